@@ -51,13 +51,15 @@ void setup() {
         cb("confirmation for received!");
     });
 
+    // the handshake runs in the background of client.loop()
+    client.on("connect", [](const String &data, ackCallback_fn cb){
+        client.send("Connected !!!!");
+    });
+
     if (!client.connect(host, port)) {
         Serial.println("connection failed");
         return;
     }
-    if (client.connected()) {
-        client.send("Connected !!!!");
-    }
 }
 
 void loop() {
@@ -66,6 +68,6 @@ void loop() {
         previousMillis = currentMillis;
         client.emit("atime", "{\"message\":\"Time please?\"}");
     }
-    client.monitor();
+    client.loop();
 }
 
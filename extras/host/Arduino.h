@@ -0,0 +1,114 @@
+/*
+Minimal Arduino core shim for building the Socket.IO client on Linux.
+Only what the library itself uses is provided: String, Print, Serial,
+millis()/micros()/delay()/yield() and random()/randomSeed()/analogRead().
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _ARDUINO_HOST_SHIM_H
+#define _ARDUINO_HOST_SHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <functional>
+#include <string>
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+int analogRead(uint8_t pin);
+
+class String {
+public:
+    String(const char *cstr = "") : _str(cstr ? cstr : "") {}
+    String(const String &str) = default;
+    explicit String(char c) : _str(1, c) {}
+    explicit String(int value) : _str(std::to_string(value)) {}
+    explicit String(unsigned int value) : _str(std::to_string(value)) {}
+    explicit String(long value) : _str(std::to_string(value)) {}
+    explicit String(unsigned long value) : _str(std::to_string(value)) {}
+    String &operator=(const String &str) = default;
+
+    const char *c_str() const { return _str.c_str(); }
+    unsigned int length() const { return _str.length(); }
+    bool reserve(unsigned int size) { _str.reserve(size); return true; }
+
+    bool concat(const char *cstr, unsigned int length) { _str.append(cstr, length); return true; }
+    String &operator+=(const String &str) { _str += str._str; return *this; }
+    String &operator+=(const char *cstr) { _str += cstr; return *this; }
+    String &operator+=(char c) { _str += c; return *this; }
+    friend String operator+(const String &lhs, const String &rhs) { String str(lhs); str += rhs; return str; }
+
+    char operator[](unsigned int index) const { return index < _str.length() ? _str[index] : 0; }
+    bool operator==(const String &rhs) const { return _str == rhs._str; }
+    bool operator==(const char *cstr) const { return _str == cstr; }
+    bool operator!=(const String &rhs) const { return _str != rhs._str; }
+    bool operator<(const String &rhs) const { return _str < rhs._str; }
+
+    int indexOf(char c, unsigned int from = 0) const { return find(_str.find(c, from)); }
+    int indexOf(const char *str, unsigned int from = 0) const { return find(_str.find(str, from)); }
+    String substring(unsigned int from, unsigned int to) const { return String(_str.substr(from, to - from).c_str()); }
+    long toInt() const { return atol(_str.c_str()); }
+
+private:
+    static int find(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+    std::string _str;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (n < size && write(buffer[n])) n++;
+        return n;
+    }
+    size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+    size_t print(const char *str) { return write(str); }
+    size_t print(const String &str) { return write(str.c_str()); }
+    size_t println(const char *str = "") { return print(str) + write("\r\n"); }
+    size_t println(const String &str) { return println(str.c_str()); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HostSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stdout); }
+    size_t write(const uint8_t *buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,202 @@
+/*
+Raw DEFLATE test vectors from zlib, compressed with
+zlib.compressobj(9, zlib.DEFLATED, -15) (the stored one at level 0) and
+flushed as permessage-deflate messages are, with the 00 00 FF FF trailer
+of the closing sync flush left out.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _DEFLATE_VECTORS_H
+#define _DEFLATE_VECTORS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// dynamic Huffman block
+static const uint8_t deflateDynamic[] = {
+    0x9c, 0x96, 0xcb, 0x4e, 0x03, 0x31, 0x0c, 0x45, 0xf7, 0x7c, 0x46, 0xd6, 0xd5, 0x28, 0x71, 0x9c,
+    0x57, 0x7f, 0x05, 0xb1, 0x18, 0xc1, 0xa8, 0x54, 0xb4, 0x05, 0xb5, 0x83, 0x10, 0x42, 0xfc, 0x3b,
+    0xdd, 0x34, 0xdc, 0x91, 0x70, 0xc6, 0x61, 0x3b, 0xa3, 0xa3, 0xeb, 0xc7, 0x8d, 0x6d, 0xa6, 0x7b,
+    0x33, 0x4f, 0x87, 0xe9, 0x38, 0xcd, 0xe7, 0x4f, 0xb3, 0xf9, 0x32, 0xfb, 0x27, 0xb3, 0xb5, 0x9b,
+    0xeb, 0xb7, 0xe3, 0x9b, 0xd9, 0xba, 0x32, 0xc4, 0x8d, 0xb9, 0xcc, 0xe3, 0xfc, 0x7e, 0x31, 0xdb,
+    0xeb, 0xbf, 0xc3, 0x64, 0xbe, 0x1f, 0xee, 0xf8, 0x2f, 0xc8, 0x55, 0x28, 0x0d, 0x09, 0xa0, 0x8f,
+    0xf1, 0x7c, 0x12, 0x21, 0xba, 0x41, 0xe4, 0x17, 0xd0, 0xeb, 0x8b, 0x88, 0xf8, 0xaa, 0x93, 0x07,
+    0x06, 0xe4, 0xf1, 0x79, 0x3c, 0xef, 0xf6, 0xa7, 0x9d, 0x08, 0x72, 0xd5, 0xe2, 0xc1, 0xea, 0xb4,
+    0x02, 0x68, 0x79, 0x1d, 0x12, 0xab, 0x0a, 0x2d, 0x90, 0x66, 0x19, 0x12, 0x40, 0xb6, 0x27, 0xa7,
+    0x0c, 0x39, 0x85, 0x1e, 0xb0, 0xd4, 0xcc, 0xe2, 0xa2, 0xc5, 0xcd, 0x30, 0xdd, 0xaf, 0x31, 0xc2,
+    0x42, 0xae, 0x4d, 0x55, 0x67, 0x90, 0x1d, 0x9c, 0xae, 0x8a, 0x8e, 0xa0, 0x22, 0xa9, 0x27, 0x31,
+    0xe7, 0x81, 0x2c, 0x4a, 0x35, 0xb4, 0x06, 0xa9, 0xf3, 0xaa, 0xee, 0x20, 0xd7, 0x19, 0x63, 0x04,
+    0xdb, 0x17, 0xf5, 0x03, 0x4b, 0x10, 0xa5, 0xeb, 0xd2, 0xcb, 0xf0, 0x36, 0xb3, 0xb2, 0x26, 0x05,
+    0x18, 0xe5, 0x73, 0x21, 0x0b, 0x79, 0x29, 0x75, 0xc8, 0x09, 0xcf, 0x72, 0x35, 0x2b, 0x22, 0xf0,
+    0x30, 0xab, 0x27, 0x8e, 0x87, 0xe1, 0x46, 0xca, 0x18, 0xd1, 0x1f, 0x51, 0xc9, 0x04, 0x88, 0x4e,
+    0xed, 0x29, 0x8a, 0x42, 0x35, 0xda, 0x54, 0xea, 0x9f, 0x53, 0x94, 0x21, 0x3e, 0x2d, 0x53, 0xe0,
+    0x25, 0x77, 0xf5, 0xca, 0x5b, 0x20, 0xd5, 0xbd, 0xf2, 0x4e, 0xe8, 0xd5, 0xba, 0x1e, 0x7a, 0x43,
+    0x39, 0x05, 0xbc, 0x17, 0xa6, 0x70, 0x3b, 0x46, 0x06, 0x25, 0xed, 0x0a, 0x0b, 0xff, 0x99, 0xa3,
+    0x1e, 0x57, 0x4b, 0x50, 0x2a, 0x25, 0xc1, 0x85, 0xeb, 0x15, 0x94, 0x56, 0x4b, 0x3b, 0x46, 0x69,
+    0xaf, 0x34, 0x62, 0x64, 0x0b, 0x79, 0xb1, 0x92, 0x71, 0xfd, 0x87, 0x03, 0xe3, 0xb1, 0xa1, 0x3e,
+    0x6b, 0x18, 0xe7, 0x45, 0xd7, 0x8a, 0x65, 0xee, 0x9f, 0xa0, 0x8c, 0x17, 0x47, 0x56, 0xc7, 0x18,
+    0xc1, 0x4f, 0x5a, 0xa5, 0x04, 0xd1, 0x75, 0x6d, 0x13, 0xce, 0xc2, 0xa5, 0xd7, 0x52, 0x2b, 0x90,
+    0x97, 0xd3, 0xe6, 0x15, 0x2c, 0xb8, 0x49, 0x7b, 0xb2, 0x39, 0xa8, 0x85, 0xef, 0xc9, 0x2b, 0x90,
+    0x30, 0xdd, 0x9a, 0x8e, 0x0f, 0x1e, 0x28, 0x65, 0x35, 0x02, 0x83, 0xa7, 0xd4, 0x47, 0x62, 0x08,
+    0x42, 0x35, 0xd6, 0x33, 0x8b, 0xc2, 0x05, 0xd6, 0xae, 0x7e, 0x12, 0xf6, 0x6b, 0x9b, 0xca, 0xc2,
+    0x3c, 0x6c, 0x53, 0x45, 0xe8, 0xda, 0xad, 0x22, 0x3f, 0x00,
+};
+
+// two sync flushes, the empty stored block between them
+static const uint8_t deflateSyncFlush[] = {
+    0x94, 0x53, 0x41, 0x0a, 0xc2, 0x30, 0x10, 0xbc, 0xfb, 0x8a, 0x92, 0xb3, 0x27, 0xe9, 0x6f, 0xc4,
+    0x43, 0xc1, 0xb4, 0x14, 0x4a, 0x02, 0xa9, 0x0a, 0xfe, 0xde, 0x6a, 0x8c, 0xee, 0x6c, 0x26, 0x8b,
+    0x5e, 0x1a, 0xb2, 0xe9, 0x4e, 0x66, 0x66, 0x27, 0xfd, 0xe1, 0xe8, 0x96, 0x38, 0xb9, 0xbd, 0xbb,
+    0x0d, 0xcb, 0xd5, 0x77, 0xc9, 0x0f, 0xe7, 0x39, 0x4c, 0xdd, 0xea, 0xc3, 0x1a, 0xd3, 0xb6, 0xbd,
+    0xa4, 0xbb, 0x2e, 0xc2, 0xe2, 0x4e, 0xbb, 0xfe, 0x83, 0x11, 0xc7, 0x71, 0x99, 0xc3, 0x17, 0xa5,
+    0xec, 0x0b, 0xf6, 0x13, 0xec, 0xdd, 0x9d, 0x4b, 0xaf, 0x2f, 0x40, 0xe8, 0xd6, 0xdc, 0x64, 0x90,
+    0xab, 0x21, 0x90, 0x66, 0x01, 0xd2, 0xdc, 0x72, 0x37, 0x5c, 0x43, 0x89, 0x48, 0xee, 0xd8, 0x93,
+    0x4f, 0xda, 0x6e, 0x60, 0x67, 0xb9, 0x55, 0x49, 0x60, 0x65, 0xca, 0x43, 0x1b, 0x83, 0x06, 0x11,
+    0x7e, 0xcc, 0x13, 0x43, 0x3c, 0x19, 0x12, 0x47, 0xa8, 0x8d, 0xa8, 0xfb, 0x99, 0x9d, 0x62, 0xf8,
+    0x12, 0x04, 0x5c, 0x54, 0x62, 0xff, 0x18, 0xab, 0x2a, 0xcb, 0x8b, 0x18, 0x0a, 0x06, 0x4a, 0x67,
+    0xc3, 0x96, 0xa2, 0xff, 0x26, 0xa2, 0xa0, 0x64, 0x3c, 0x14, 0x74, 0x10, 0x15, 0x32, 0x78, 0x9a,
+    0x0c, 0xf6, 0x2c, 0x41, 0x82, 0x15, 0x72, 0x79, 0xce, 0x10, 0xc8, 0xe6, 0x07, 0x25, 0xed, 0xb0,
+    0x36, 0x73, 0x6e, 0x4f, 0xa4, 0xf1, 0x7e, 0xda, 0x39, 0x35, 0x4c, 0xa1, 0x41, 0x22, 0xb6, 0x60,
+    0x1a, 0xf8, 0x54, 0x84, 0xcd, 0x1b, 0xc2, 0x03, 0x00, 0x00, 0xff, 0xff, 0x54, 0xd0, 0x21, 0x16,
+    0xc2, 0x40, 0x10, 0x44, 0xc1, 0xbb, 0xa0, 0x23, 0x98, 0x6e, 0x12, 0xe0, 0x38, 0x3c, 0x24, 0xf7,
+    0xf7, 0x21, 0xae, 0xd6, 0xb5, 0xda, 0x5f, 0xb3, 0xd7, 0x0b, 0x9f, 0xef, 0xef, 0xb6, 0xdd, 0xd9,
+    0xc3, 0x0e, 0xbb, 0xec, 0x07, 0x7b, 0x67, 0x1f, 0xec, 0x27, 0xfb, 0xc5, 0x7e, 0xdb, 0x5a, 0xc2,
+    0x96, 0xc7, 0xf4, 0xd8, 0x1e, 0xe3, 0x63, 0x7d, 0xcc, 0x8f, 0xfd, 0x11, 0x30, 0x0a, 0xa2, 0x20,
+    0xcb, 0xed, 0x0a, 0xa2, 0x20, 0x0a, 0xa2, 0x20, 0x0a, 0xa2, 0x20, 0x0a, 0xa2, 0xa0, 0x0a, 0xaa,
+    0xa0, 0xcb, 0xf7, 0x2b, 0xa8, 0x82, 0x2a, 0xa8, 0x82, 0x2a, 0xa8, 0x82, 0xfe, 0x05, 0x27, 0x00,
+};
+
+// stored block of incompressible data
+static const uint8_t deflateStored[] = {
+    0x00, 0x2c, 0x01, 0xd3, 0xfe, 0xae, 0x32, 0x03, 0x70, 0x40, 0xf1, 0x9c, 0x05, 0xf5, 0x1a, 0x84,
+    0xcc, 0x6a, 0x0e, 0xe6, 0x40, 0x79, 0xda, 0x50, 0x9a, 0xdf, 0x38, 0xa3, 0x0f, 0xae, 0x46, 0x21,
+    0x4c, 0x09, 0xcc, 0x2f, 0xf9, 0x5a, 0xc9, 0xfb, 0xe6, 0x67, 0xee, 0x01, 0xe0, 0xfa, 0xeb, 0x4d,
+    0xf7, 0xdb, 0x18, 0x07, 0x51, 0x70, 0x3f, 0x6a, 0x9a, 0x52, 0x7d, 0x90, 0x58, 0xe1, 0xd6, 0xe4,
+    0x66, 0x6e, 0x35, 0x14, 0x46, 0x4d, 0x76, 0x77, 0x9c, 0xec, 0x91, 0x74, 0x70, 0x62, 0x2f, 0x54,
+    0x66, 0x0f, 0x53, 0x17, 0x2b, 0x51, 0x8b, 0x06, 0x30, 0x36, 0xb6, 0x5d, 0xa8, 0xe5, 0x23, 0xf1,
+    0xa0, 0x15, 0x56, 0xf9, 0x72, 0xf6, 0x9b, 0x99, 0xc2, 0xf0, 0xe2, 0xab, 0xbb, 0x62, 0x36, 0xb2,
+    0x8a, 0xc5, 0x55, 0x13, 0x04, 0xab, 0x8d, 0x6b, 0x78, 0x3a, 0xdd, 0xba, 0x52, 0xc3, 0xd5, 0xcc,
+    0x83, 0x80, 0x19, 0x76, 0xb7, 0x00, 0x48, 0xea, 0x88, 0x34, 0x12, 0x39, 0x02, 0xfb, 0xeb, 0x50,
+    0x0a, 0x17, 0x26, 0x54, 0x29, 0xb1, 0x18, 0x82, 0xd2, 0xca, 0xfe, 0x67, 0xa6, 0xd6, 0x65, 0x63,
+    0xe3, 0x96, 0x81, 0xde, 0x22, 0x82, 0xb0, 0x5b, 0x5b, 0xf2, 0x45, 0x33, 0x52, 0xea, 0x62, 0x91,
+    0x2e, 0xcc, 0x9c, 0xc6, 0xde, 0x2d, 0x92, 0x2b, 0x02, 0x4e, 0xaf, 0xe3, 0x05, 0x47, 0x7a, 0x85,
+    0xdd, 0xc1, 0xad, 0x6d, 0xe8, 0xfa, 0xc1, 0x17, 0x45, 0x48, 0x24, 0x84, 0x73, 0x7a, 0xae, 0xfe,
+    0x3b, 0x2d, 0x54, 0x25, 0xbf, 0xad, 0x58, 0xbe, 0x99, 0x0d, 0x8b, 0x47, 0xed, 0x58, 0x06, 0x94,
+    0x2f, 0x89, 0xc7, 0xf3, 0xab, 0xc3, 0x18, 0x74, 0x22, 0x57, 0x35, 0xbf, 0x8b, 0x22, 0xe7, 0x6c,
+    0x37, 0x83, 0x33, 0xd6, 0xaf, 0x91, 0x6c, 0x02, 0xd8, 0x8e, 0xff, 0x0c, 0xef, 0xc6, 0xb7, 0x5a,
+    0x7f, 0x5f, 0x0f, 0x5f, 0xce, 0xcc, 0x66, 0xe2, 0x76, 0x6f, 0xa1, 0xba, 0xf6, 0x30, 0x8e, 0x19,
+    0xea, 0x2a, 0xf6, 0x96, 0x15, 0xe4, 0x5a, 0x42, 0xe3, 0x3f, 0xc4, 0x78, 0xf8, 0x86, 0x2f, 0xc2,
+    0x87, 0x03, 0xee, 0xa9, 0x8a, 0x55, 0xab, 0x39, 0xf9, 0xff, 0x2c, 0x07, 0x0e, 0xb7, 0xda, 0x96,
+    0x94, 0x00,
+};
+
+// back references 31 KB away
+static const uint8_t deflateFar[] = {
+    0xec, 0xdd, 0xc9, 0x61, 0xc4, 0x20, 0x0c, 0x05, 0xd0, 0x96, 0x24, 0x01, 0x02, 0xca, 0xd1, 0x82,
+    0x6a, 0x48, 0xf9, 0x91, 0x7b, 0xc8, 0x2d, 0xff, 0x9d, 0x6c, 0x0f, 0xc6, 0xda, 0xe6, 0x8c, 0xda,
+    0x9d, 0x76, 0x83, 0x25, 0xf6, 0x7b, 0x6c, 0x6b, 0x6a, 0xcc, 0xe0, 0x98, 0x37, 0x6b, 0x8d, 0x3a,
+    0xc7, 0x9d, 0x94, 0xdf, 0x1d, 0x4a, 0xfa, 0xc6, 0xb9, 0x77, 0xd3, 0xca, 0x7e, 0x68, 0x8b, 0xa6,
+    0x0a, 0x2b, 0x9d, 0xe7, 0x2e, 0x23, 0x73, 0xf1, 0x9e, 0xe9, 0xea, 0xc9, 0xcb, 0xce, 0xbb, 0x37,
+    0x73, 0xb0, 0xef, 0x5e, 0xfa, 0x5c, 0x72, 0xc9, 0xb0, 0x2c, 0xba, 0x29, 0x71, 0xb4, 0x16, 0xed,
+    0x4b, 0xe3, 0xdb, 0x2f, 0xce, 0x92, 0x3b, 0x73, 0xe9, 0xad, 0x5b, 0xf6, 0xb8, 0x44, 0xd2, 0xa4,
+    0xd6, 0xac, 0xac, 0x41, 0xf7, 0xc9, 0x59, 0x87, 0xec, 0xf5, 0xd7, 0x96, 0x99, 0x95, 0xd8, 0xed,
+    0x10, 0x38, 0x4a, 0x6e, 0xee, 0x77, 0xe3, 0xb1, 0xae, 0x21, 0x22, 0x97, 0xea, 0xf2, 0x5b, 0x4b,
+    0xce, 0x18, 0xeb, 0xf8, 0xd9, 0xaa, 0xa5, 0x79, 0xde, 0x0e, 0x39, 0x67, 0x2e, 0x8a, 0xf9, 0x6a,
+    0x8c, 0x08, 0x9b, 0xdb, 0x76, 0x47, 0x2b, 0xd4, 0x51, 0xed, 0x47, 0xef, 0xd8, 0x72, 0xb9, 0x7a,
+    0x56, 0x0c, 0xda, 0x93, 0x96, 0xc4, 0xcc, 0x53, 0x92, 0xf3, 0x8c, 0x39, 0xeb, 0x90, 0x8f, 0xdb,
+    0x3f, 0xd4, 0xf2, 0xa3, 0xcb, 0x68, 0x8b, 0x52, 0x50, 0x11, 0xeb, 0xbd, 0x92, 0xaa, 0xbd, 0x91,
+    0x5a, 0x7f, 0xf7, 0xf8, 0xe8, 0xcf, 0x30, 0xbb, 0x4c, 0xa3, 0xb3, 0x17, 0x71, 0x52, 0x5f, 0xeb,
+    0x7c, 0xcf, 0x5e, 0x6d, 0xad, 0xd3, 0x99, 0xf5, 0xdd, 0xaa, 0x91, 0xbe, 0xec, 0x0d, 0x9e, 0xe2,
+    0x1d, 0xd9, 0x38, 0x2f, 0x35, 0xf4, 0x86, 0xf9, 0x57, 0x4b, 0x36, 0x79, 0xe9, 0x64, 0xeb, 0x1d,
+    0xe6, 0x0e, 0x9e, 0x4e, 0xb0, 0xe6, 0x30, 0x8e, 0x91, 0x72, 0x7d, 0x53, 0xad, 0xae, 0xb2, 0x67,
+    0xf8, 0xa5, 0xb4, 0x22, 0xd3, 0x3d, 0xc2, 0x43, 0x3c, 0x4b, 0x3d, 0x76, 0xc7, 0x2a, 0x79, 0xef,
+    0xeb, 0x1d, 0x2d, 0xbb, 0x62, 0x2c, 0xfc, 0x4c, 0xc7, 0x9e, 0xbe, 0x9d, 0xd7, 0x1d, 0x93, 0x48,
+    0x77, 0x6c, 0xbe, 0x23, 0xf8, 0xec, 0xb7, 0x97, 0xfb, 0x61, 0xb2, 0x2b, 0xd4, 0x45, 0xeb, 0xb6,
+    0x3e, 0xef, 0x7e, 0xec, 0xce, 0x40, 0x98, 0x78, 0x98, 0x18, 0x0f, 0x5e, 0x1c, 0x7a, 0x68, 0xf3,
+    0xda, 0xfa, 0x84, 0xb4, 0x2c, 0x85, 0xfa, 0x05, 0x92, 0x63, 0xd1, 0xc5, 0xa5, 0x11, 0xab, 0x5f,
+    0x96, 0xad, 0x1d, 0xbb, 0x16, 0xa9, 0x5f, 0xab, 0x74, 0xf1, 0x61, 0xbe, 0xee, 0x7c, 0xb3, 0x9e,
+    0xeb, 0x94, 0x53, 0xb4, 0x46, 0x50, 0xf6, 0xba, 0xae, 0xd8, 0x4b, 0xa6, 0x6b, 0x53, 0x58, 0xaa,
+    0xd7, 0x96, 0xdf, 0x5e, 0xa5, 0x33, 0x59, 0xd6, 0xa4, 0xb7, 0xe7, 0x3c, 0x94, 0x6b, 0xe6, 0x4e,
+    0x65, 0x1a, 0xda, 0x33, 0xd1, 0x73, 0xd5, 0x99, 0xc5, 0xa5, 0xae, 0x59, 0x74, 0x06, 0x6a, 0xa3,
+    0xb7, 0x4d, 0xeb, 0x94, 0xed, 0xf4, 0xec, 0xbc, 0x33, 0x38, 0x96, 0x39, 0x1d, 0x99, 0x8f, 0xfa,
+    0xb5, 0x1e, 0x8d, 0xde, 0x67, 0x77, 0x3e, 0x5b, 0x96, 0x65, 0x54, 0x44, 0x3c, 0xb9, 0xaf, 0x2b,
+    0x52, 0x4b, 0xbf, 0x0a, 0x6b, 0x27, 0x7a, 0xbb, 0xb0, 0x7b, 0xbc, 0x17, 0xa9, 0x7e, 0xe8, 0x49,
+    0x37, 0xe3, 0x6b, 0xf3, 0xce, 0xa1, 0x27, 0xd9, 0xb8, 0xcc, 0x7a, 0x18, 0x27, 0x67, 0x2f, 0xcc,
+    0xaf, 0x72, 0x3d, 0xbb, 0x71, 0xa4, 0x2b, 0xe8, 0x37, 0x3b, 0x8d, 0x9b, 0x11, 0x5d, 0x97, 0xd1,
+    0x53, 0xf8, 0x8a, 0x3b, 0x82, 0x79, 0xa5, 0xfb, 0x9e, 0xb5, 0x07, 0x9f, 0xbb, 0x79, 0x52, 0x0f,
+    0x6a, 0xee, 0x15, 0x87, 0x2f, 0x8f, 0xd9, 0x4f, 0x5e, 0x8f, 0xc6, 0xf0, 0x57, 0xd1, 0xb7, 0xe5,
+    0xa6, 0xe2, 0xf5, 0xc6, 0x1e, 0x92, 0xfd, 0x2f, 0xe8, 0x8b, 0x59, 0x2c, 0xf6, 0x4e, 0xc5, 0x8a,
+    0x7d, 0xd6, 0xae, 0x4b, 0x3a, 0xba, 0x75, 0x5d, 0xbb, 0xf9, 0x2c, 0x56, 0xdd, 0x23, 0x95, 0x2f,
+    0xc2, 0x77, 0xef, 0xeb, 0x25, 0x3d, 0xbd, 0xab, 0x8b, 0xd5, 0xc9, 0xcb, 0x5e, 0x6a, 0x5f, 0xab,
+    0x47, 0x88, 0xad, 0x6e, 0xc9, 0xde, 0x7e, 0x8c, 0x4f, 0xdd, 0xe9, 0x49, 0xf3, 0xf9, 0xd2, 0x79,
+    0xd8, 0xe6, 0xdc, 0xdd, 0x26, 0xfe, 0xba, 0xd0, 0x53, 0x1a, 0x3e, 0xc6, 0x25, 0xaf, 0x1f, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x3f, 0xa2, 0x38, 0x2f, 0x19, 0xe7, 0x25,
+    0xe3, 0xbc, 0xe4, 0x7f, 0x7b, 0x5e, 0xf2, 0x2f, 0x00,
+};
+
+// final dynamic block, no sync flush
+static const uint8_t deflateFinal[] = {
+    0x9d, 0x96, 0xcb, 0x4e, 0x03, 0x31, 0x0c, 0x45, 0xf7, 0x7c, 0x46, 0xd6, 0xd5, 0x28, 0x71, 0x9c,
+    0x57, 0x7f, 0x05, 0xb1, 0x18, 0xc1, 0xa8, 0x54, 0xb4, 0x05, 0xb5, 0x83, 0x10, 0x42, 0xfc, 0x3b,
+    0xdd, 0x34, 0xdc, 0x91, 0x70, 0xc6, 0x61, 0x3b, 0xa3, 0xa3, 0xeb, 0xc7, 0x8d, 0x6d, 0xa6, 0x7b,
+    0x33, 0x4f, 0x87, 0xe9, 0x38, 0xcd, 0xe7, 0x4f, 0xb3, 0xf9, 0x32, 0xfb, 0x27, 0xb3, 0xb5, 0x9b,
+    0xeb, 0xb7, 0xe3, 0x9b, 0xd9, 0xba, 0x32, 0xc4, 0x8d, 0xb9, 0xcc, 0xe3, 0xfc, 0x7e, 0x31, 0xdb,
+    0xeb, 0xbf, 0xc3, 0x64, 0xbe, 0x1f, 0xee, 0xf8, 0x2f, 0xc8, 0x55, 0x28, 0x0d, 0x09, 0xa0, 0x8f,
+    0xf1, 0x7c, 0x12, 0x21, 0xba, 0x41, 0xe4, 0x17, 0xd0, 0xeb, 0x8b, 0x88, 0xf8, 0xaa, 0x93, 0x07,
+    0x06, 0xe4, 0xf1, 0x79, 0x3c, 0xef, 0xf6, 0xa7, 0x9d, 0x08, 0x72, 0xd5, 0xe2, 0xc1, 0xea, 0xb4,
+    0x02, 0x68, 0x79, 0x1d, 0x12, 0xab, 0x0a, 0x2d, 0x90, 0x66, 0x19, 0x12, 0x40, 0xb6, 0x27, 0xa7,
+    0x0c, 0x39, 0x85, 0x1e, 0xb0, 0xd4, 0xcc, 0xe2, 0xa2, 0xc5, 0xcd, 0x30, 0xdd, 0xaf, 0x31, 0xc2,
+    0x42, 0xae, 0x4d, 0x55, 0x67, 0x90, 0x1d, 0x9c, 0xae, 0x8a, 0x8e, 0xa0, 0x22, 0xa9, 0x27, 0x31,
+    0xe7, 0x81, 0x2c, 0x4a, 0x35, 0xb4, 0x06, 0xa9, 0xf3, 0xaa, 0xee, 0x20, 0xd7, 0x19, 0x63, 0x04,
+    0xdb, 0x17, 0xf5, 0x03, 0x4b, 0x10, 0xa5, 0xeb, 0xd2, 0xcb, 0xf0, 0x36, 0xb3, 0xb2, 0x26, 0x05,
+    0x18, 0xe5, 0x73, 0x21, 0x0b, 0x79, 0x29, 0x75, 0xc8, 0x09, 0xcf, 0x72, 0x35, 0x2b, 0x22, 0xf0,
+    0x30, 0xab, 0x27, 0x8e, 0x87, 0xe1, 0x46, 0xca, 0x18, 0xd1, 0x1f, 0x51, 0xc9, 0x04, 0x88, 0x4e,
+    0xed, 0x29, 0x8a, 0x42, 0x35, 0xda, 0x54, 0xea, 0x9f, 0x53, 0x94, 0x21, 0x3e, 0x2d, 0x53, 0xe0,
+    0x25, 0x77, 0xf5, 0xca, 0x5b, 0x20, 0xd5, 0xbd, 0xf2, 0x4e, 0xe8, 0xd5, 0xba, 0x1e, 0x7a, 0x43,
+    0x39, 0x05, 0xbc, 0x17, 0xa6, 0x70, 0x3b, 0x46, 0x06, 0x25, 0xed, 0x0a, 0x0b, 0xff, 0x99, 0xa3,
+    0x1e, 0x57, 0x4b, 0x50, 0x2a, 0x25, 0xc1, 0x85, 0xeb, 0x15, 0x94, 0x56, 0x4b, 0x3b, 0x46, 0x69,
+    0xaf, 0x34, 0x62, 0x64, 0x0b, 0x79, 0xb1, 0x92, 0x71, 0xfd, 0x87, 0x03, 0xe3, 0xb1, 0xa1, 0x3e,
+    0x6b, 0x18, 0xe7, 0x45, 0xd7, 0x8a, 0x65, 0xee, 0x9f, 0xa0, 0x8c, 0x17, 0x47, 0x56, 0xc7, 0x18,
+    0xc1, 0x4f, 0x5a, 0xa5, 0x04, 0xd1, 0x75, 0x6d, 0x13, 0xce, 0xc2, 0xa5, 0xd7, 0x52, 0x2b, 0x90,
+    0x97, 0xd3, 0xe6, 0x15, 0x2c, 0xb8, 0x49, 0x7b, 0xb2, 0x39, 0xa8, 0x85, 0xef, 0xc9, 0x2b, 0x90,
+    0x30, 0xdd, 0x9a, 0x8e, 0x0f, 0x1e, 0x28, 0x65, 0x35, 0x02, 0x83, 0xa7, 0xd4, 0x47, 0x62, 0x08,
+    0x42, 0x35, 0xd6, 0x33, 0x8b, 0xc2, 0x05, 0xd6, 0xae, 0x7e, 0x12, 0xf6, 0x6b, 0x9b, 0xca, 0xc2,
+    0x3c, 0x6c, 0x53, 0x45, 0xe8, 0xda, 0xad, 0x22, 0x3f,
+};
+
+struct deflateVector_t {
+    const char *name;
+    const uint8_t *data;
+    size_t length;
+    size_t inflated;
+    uint32_t crc;
+};
+
+static const deflateVector_t deflateVectors[] = {
+    { "dynamic", deflateDynamic, sizeof(deflateDynamic), 3240, 0x838aa40eUL },
+    { "sync_flush", deflateSyncFlush, sizeof(deflateSyncFlush), 1868, 0xbf5c7629UL },
+    { "stored", deflateStored, sizeof(deflateStored), 300, 0x0cdf7d2cUL },
+    { "far", deflateFar, sizeof(deflateFar), 32048, 0x2175aa0fUL },
+    { "final", deflateFinal, sizeof(deflateFinal), 3240, 0x838aa40eUL },
+};
+
+#endif
@@ -0,0 +1,181 @@
+/*
+Non-blocking epoll socket transport for host builds of the Socket.IO client.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <EpollClient.h>
+#include <algorithm>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+const size_t EpollClient::QUEUE_LIMIT;
+
+int EpollClient::connect(const char *host, uint16_t port) {
+    stop();
+
+    struct addrinfo hints;
+    struct addrinfo *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &result) != 0) return 0;
+
+    // the connection is set up in the background, writes wait in the queue meanwhile
+    for (struct addrinfo *ai = result; ai != NULL; ai = ai->ai_next) {
+        _fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK, ai->ai_protocol);
+        if (_fd < 0) continue;
+        if (::connect(_fd, ai->ai_addr, ai->ai_addrlen) == 0 || errno == EINPROGRESS) break;
+        close(_fd);
+        _fd = -1;
+    }
+    freeaddrinfo(result);
+    if (_fd < 0) return 0;
+
+    int one = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.ptr = _owner;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _fd, &event) != 0) {
+        stop();
+        return 0;
+    }
+    _eof = false;
+    _watchingOut = false;
+    _position = _length = 0;
+    return 1;
+}
+
+size_t EpollClient::write(const uint8_t *buf, size_t size) {
+    if (_fd < 0 || _eof) return 0;
+    size_t written = 0;
+    if (_out.empty()) {
+        ssize_t n = send(_fd, buf, size, MSG_NOSIGNAL);
+        if (n > 0) {
+            written = n;
+        } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            lost();
+            return 0;
+        }
+    }
+    size_t queue = std::min(size - written, QUEUE_LIMIT - std::min(QUEUE_LIMIT, _out.size()));
+    _out.append((const char *)buf + written, queue);
+    if (!_out.empty()) watch(true);
+    return written + queue;
+}
+
+void EpollClient::flush() {
+    while (_fd >= 0 && !_out.empty()) {
+        ssize_t n = send(_fd, _out.data(), _out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            _out.erase(0, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) lost();
+            break;
+        }
+    }
+    watch(!_out.empty() && !_eof);
+}
+
+void EpollClient::handle(uint32_t events) {
+    if (events & EPOLLERR) {
+        lost();
+        return;
+    }
+    if (events & EPOLLOUT) {
+        flush();
+    }
+}
+
+/// The socket failed or was closed, it leaves the epoll set so it is not reported again and again
+void EpollClient::lost() {
+    if (!_eof && _fd >= 0) {
+        epoll_ctl(_epoll, EPOLL_CTL_DEL, _fd, NULL);
+    }
+    _eof = true;
+}
+
+void EpollClient::watch(bool writable) {
+    if (_fd < 0 || _eof || writable == _watchingOut) return;
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | (writable ? (uint32_t)EPOLLOUT : 0u);
+    event.data.ptr = _owner;
+    epoll_ctl(_epoll, EPOLL_CTL_MOD, _fd, &event);
+    _watchingOut = writable;
+}
+
+bool EpollClient::fill() {
+    if (_position < _length) return true;
+    if (_fd < 0 || _eof) return false;
+    ssize_t n = recv(_fd, _buffer, sizeof(_buffer), 0);
+    if (n > 0) {
+        _position = 0;
+        _length = n;
+        return true;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        lost();
+    }
+    return false;
+}
+
+int EpollClient::available() {
+    return fill() ? _length - _position : 0;
+}
+
+int EpollClient::read() {
+    return fill() ? _buffer[_position++] : -1;
+}
+
+int EpollClient::read(uint8_t *buf, size_t size) {
+    if (!fill()) return -1;
+    size_t n = _length - _position;
+    if (n > size) n = size;
+    memcpy(buf, &_buffer[_position], n);
+    _position += n;
+    return n;
+}
+
+int EpollClient::peek() {
+    return fill() ? _buffer[_position] : -1;
+}
+
+void EpollClient::stop() {
+    if (_fd >= 0) {
+        // closing the socket takes it out of the epoll set
+        close(_fd);
+    }
+    _fd = -1;
+    _position = _length = 0;
+    _out.clear();
+}
+
+uint8_t EpollClient::connected() {
+    fill();
+    return _fd >= 0 && (!_eof || _position < _length);
+}
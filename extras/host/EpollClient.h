@@ -0,0 +1,76 @@
+/*
+Non-blocking epoll socket transport for host builds of the Socket.IO client.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _EPOLL_CLIENT_H
+#define _EPOLL_CLIENT_H
+
+#include <Client.h>
+#include <string>
+
+/**
+ * Arduino Client over a non-blocking socket in an epoll set, for driving
+ * many connections from one thread. connect() returns while the connection
+ * is still being set up, write() queues what the socket does not take yet,
+ * up to a limit, and handle() sends it once epoll reports the socket
+ * writable. The epoll events carry the owner pointer given at construction.
+ */
+class EpollClient : public Client {
+public:
+    EpollClient(int epoll, void *owner) : _epoll(epoll), _owner(owner) {}
+    ~EpollClient() { stop(); }
+
+    int connect(const char *host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    using Print::write;
+
+    /// Takes the epoll events of the socket
+    void handle(uint32_t events);
+    /// Bytes queued that the socket did not take yet
+    size_t queued() const { return _out.size(); }
+
+    /// Most bytes write() queues, beyond them it takes less than it is given
+    static const size_t QUEUE_LIMIT = 65536;
+
+private:
+    bool fill();
+    void watch(bool writable);
+    void lost();
+
+    int _epoll;
+    void *_owner;
+    int _fd = -1;
+    bool _eof = false;
+    bool _watchingOut = false;
+    uint8_t _buffer[2048];
+    size_t _position = 0;
+    size_t _length = 0;
+    std::string _out;
+};
+
+#endif
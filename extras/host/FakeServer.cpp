@@ -0,0 +1,397 @@
+/*
+Stand-in engine.io/socket.io server for host builds.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <FakeServer.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+std::atomic<unsigned long> FakeSession::eventsReceived{0};
+std::atomic<bool> FakeSession::directWebSocket{true};
+std::atomic<int> FakeSession::closeAfterPolling{0};
+std::atomic<unsigned long> FakeSession::pingInterval{25000};
+std::atomic<unsigned long> FakeSession::pingTimeout{5000};
+std::atomic<unsigned long> FakeSession::maxPayload{0};
+std::atomic<bool> FakeSession::heartbeat{true};
+static std::atomic<unsigned long> sessionCount{0};
+
+std::string FakeSession::openPacket() {
+    // as long as engine.io's, the handshake requests carry it twice
+    char sid[21];
+    snprintf(sid, sizeof(sid), "fake%016lu", ++sessionCount);
+    _sid = sid;
+    char packet[200];
+    int length = snprintf(packet, sizeof(packet),
+        "0{\"sid\":\"%s\",\"upgrades\":[\"websocket\"],\"pingInterval\":%lu,\"pingTimeout\":%lu",
+        _sid.c_str(), pingInterval.load(), pingTimeout.load());
+    if (maxPayload) {
+        length += snprintf(&packet[length], sizeof(packet) - length, ",\"maxPayload\":%lu", maxPayload.load());
+    }
+    snprintf(&packet[length], sizeof(packet) - length, "}");
+    _lastPing = millis();
+    return packet;
+}
+
+FakeSession::FakeSession() :
+    _message(65536 + 1), _decoder(_message.data(), _message.size()) {
+}
+
+void FakeSession::receive(const uint8_t *data, size_t length, std::string &out) {
+    size_t offset = 0;
+    while (!_websocket && !_closed && offset < length) {
+        _request += (char)data[offset++];
+        size_t size = _request.size();
+        if (size >= 4 && _request.compare(size - 4, 4, "\r\n\r\n") == 0) {
+            handleRequest(out);
+            _request.clear();
+        }
+    }
+
+    while (_websocket && !_closed && offset < length) {
+        size_t consumed;
+        wsDecodeResult_t result = _decoder.feed(&data[offset], length - offset, consumed);
+        offset += consumed;
+        switch (result) {
+            case wsDecode_MESSAGE:
+                if (_decoder.truncated()) break;
+#ifdef SOCKETIO_DEFLATE
+                if (_decoder.compressed()) {
+                    size_t inflated;
+                    if (!_inflater.inflate(_message.data(), _decoder.length(), _message.size() - 1, inflated)) {
+                        _closed = true;
+                        break;
+                    }
+                    _decoder.setLength(inflated);
+                }
+#endif
+                if (_attachmentsPending && (_decoder.opcode() == wsOp_BINARY || _decoder.payload()[0] == 'b')) {
+                    appendFrame(_attachmentFrames, (const char *)_decoder.payload(), _decoder.length(), _decoder.opcode());
+                    if (--_attachmentsPending == 0) {
+                        handleEvent(_binaryPacket, out);
+                    }
+                } else if (_decoder.opcode() == wsOp_TEXT) {
+                    handleMessage((const char *)_decoder.payload(), _decoder.length(), out);
+                }
+                break;
+            case wsDecode_CONTROL:
+                if (_decoder.opcode() == wsOp_PING) {
+                    appendFrame(out, (const char *)_decoder.payload(), _decoder.length(), wsOp_PONG);
+                } else if (_decoder.opcode() == wsOp_CLOSE) {
+                    appendFrame(out, (const char *)_decoder.payload(), _decoder.length(), wsOp_CLOSE);
+                    _closed = true;
+                }
+                break;
+            case wsDecode_ERROR:
+                _closed = true;
+                break;
+            case wsDecode_PARTIAL:
+            case wsDecode_NEED_MORE:
+                break;
+        }
+    }
+}
+
+void FakeSession::handleRequest(std::string &out) {
+    bool direct = _request.find("sid=") == std::string::npos;
+    _eio4 = _request.find("EIO=4") != std::string::npos;
+    if (_request.find("transport=polling") != std::string::npos) {
+        std::string packet = openPacket();
+        // EIO 3 b64 payload: <length>:<packet> for every packet, the
+        // default namespace joined, EIO 4 the open packet alone
+        std::string body = _eio4 ? packet : std::to_string(packet.size()) + ":" + packet + "2:40";
+        out += "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/plain; charset=UTF-8\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+            (closeAfterPolling == 1 ? "Connection: close\r\n" : "Connection: keep-alive\r\n") +
+            "\r\n" + body;
+        _closed = closeAfterPolling != 0;
+    } else if (_request.find("transport=websocket") != std::string::npos && (!direct || directWebSocket)) {
+        std::string extensions;
+#ifdef SOCKETIO_DEFLATE
+        // accept the offer as it is, the server never takes over its context
+        size_t offer = _request.find("Sec-WebSocket-Extensions: permessage-deflate");
+        if (offer != std::string::npos) {
+            std::string parameters = _request.substr(offer, _request.find("\r\n", offer) - offer);
+            extensions = "Sec-WebSocket-Extensions: permessage-deflate";
+            if (parameters.find("server_no_context_takeover") != std::string::npos) {
+                extensions += "; server_no_context_takeover";
+            }
+            size_t bits = parameters.find("server_max_window_bits=");
+            if (bits != std::string::npos) {
+                extensions += "; " + parameters.substr(bits, 25);
+                _deflater.setWindowBits(atoi(&parameters[bits + 23]));
+            }
+            extensions += "\r\n";
+            _deflate = true;
+            _inflater.reset();
+            _decoder.allowCompression(true);
+        }
+#endif
+        out += "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Accept: 7bIYaB1aAbmwWlnDxzWuIQCt5Bw=\r\n" + extensions +
+            "\r\n";
+        _websocket = true;
+        if (direct) {
+            // the session starts on the WebSocket, its open packet first
+            send(out, openPacket());
+            if (!_eio4) {
+                send(out, "40");
+            }
+        }
+    } else {
+        out += "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n";
+        _closed = true;
+    }
+}
+
+void FakeSession::handleMessage(const char *payload, size_t length, std::string &out) {
+    std::string message(payload, length);
+    if (message == "2probe") {
+        send(out, "3probe");
+    } else if (message == "5") {
+        // Socket.IO 2 joined the default namespace in the polling response already
+        _lastPing = millis();
+    } else if (message == "2") {
+        // EIO 4 clients only answer pings
+        _closed = _eio4;
+        if (heartbeat && !_eio4) {
+            send(out, "3");
+        }
+    } else if (message == "40" && _eio4) {
+        send(out, "40{\"sid\":\"" + _sid + "\"}");
+    } else if (message.compare(0, 3, "40/") == 0) {
+        // namespaces are accepted, but for /private
+        std::string nsp = message.substr(2, message.find(',') - 2);
+        send(out, nsp == "/private" ? "44" + nsp + ",{\"message\":\"Not authorized\"}" : "40" + nsp + ",");
+    } else if (length > 2 && payload[0] == eIOtype_MESSAGE && (payload[1] == sIOtype_EVENT || payload[1] == sIOtype_ACK)) {
+        handleEvent(message, out);
+    } else if (length > 2 && payload[0] == eIOtype_MESSAGE &&
+        (payload[1] == sIOtype_BINARY_EVENT || payload[1] == sIOtype_BINARY_ACK)) {
+        socketIOPacketView_t packet;
+        if (!SocketIOClient::parse((socketIOmessageType_t)payload[1], &payload[2], length - 2, packet)) return;
+        _binaryPacket = message;
+        _attachmentFrames.clear();
+        _attachmentsPending = packet.attachments;
+        if (_attachmentsPending == 0) {
+            handleEvent(_binaryPacket, out);
+        }
+    }
+}
+
+void FakeSession::handleEvent(const std::string &message, std::string &out) {
+    socketIOmessageType_t type = (socketIOmessageType_t)message[1];
+    socketIOPacketView_t packet;
+    if (!SocketIOClient::parse(type, &message[2], message.size() - 2, packet)) return;
+    std::string data(packet.data.ptr ? packet.data.ptr : "", packet.data.length);
+    bool binaryPacket = type == sIOtype_BINARY_EVENT || type == sIOtype_BINARY_ACK;
+    std::string binary = binaryPacket ? std::to_string(packet.attachments) + "-" : "";
+    std::string nsp = packet.nsp.empty() ? "" : std::string(packet.nsp.ptr, packet.nsp.length) + ",";
+    if (type == sIOtype_ACK || type == sIOtype_BINARY_ACK) {
+        // the client's answer to an "ask", its arguments come back as those of an "answer" event
+        send(out, (binaryPacket ? "45" : "42") + binary + nsp + "[\"answer\"" + (data.empty() ? "" : "," + data) + "]");
+        out += _attachmentFrames;
+        _attachmentFrames.clear();
+        return;
+    }
+    eventsReceived++;
+    const char *ack = type == sIOtype_BINARY_EVENT ? "46" : "43";
+    if (!packet.id.empty()) {
+        send(out, ack + binary + nsp + std::string(packet.id.ptr, packet.id.length) + "[" + data + "]");
+        out += _attachmentFrames;
+    }
+    if (packet.event.equals("echo")) {
+        send(out, message.substr(0, 2) + binary + nsp + "[\"echo\"" + (data.empty() ? "" : "," + data) + "]");
+        out += _attachmentFrames;
+    } else if (packet.event.equals("kick") && !nsp.empty()) {
+        send(out, "41" + nsp);
+    } else if (packet.event.length >= 3 && strncmp(packet.event.ptr, "ask", 3) == 0) {
+        // sent back asking the client for an ack
+        send(out, "42" + nsp + std::to_string(++_asked) + "[\"" + std::string(packet.event.ptr, packet.event.length) +
+            "\"" + (data.empty() ? "" : "," + data) + "]");
+    }
+    _attachmentFrames.clear();
+}
+
+void FakeSession::tick(std::string &out) {
+    if (!_eio4 || !_websocket || _closed || !heartbeat || millis() - _lastPing < pingInterval) return;
+    _lastPing = millis();
+    send(out, "2");
+}
+
+void FakeSession::send(std::string &out, const std::string &payload) {
+#ifdef SOCKETIO_DEFLATE
+    if (_deflate && payload.size() >= 64) {
+        std::vector<uint8_t> compressed(payload.size());
+        size_t length = _deflater.deflate((const uint8_t *)payload.data(), payload.size(), compressed.data(), compressed.size());
+        if (length) {
+            appendFrame(out, (const char *)compressed.data(), length, wsOp_TEXT, true);
+            return;
+        }
+    }
+#endif
+    appendFrame(out, payload);
+}
+
+void FakeSession::appendFrame(std::string &out, const char *payload, size_t length, wsOpcode_t opcode, bool compressed) {
+    out += (char)(0x80 | opcode | (compressed ? 0x40 : 0));
+    if (length <= 125) {
+        out += (char)length;
+    } else if (length <= 65535) {
+        out += (char)126;
+        out += (char)(length >> 8);
+        out += (char)length;
+    } else {
+        out += (char)127;
+        for (int i = 7; i >= 0; i--) {
+            out += (char)((uint64_t)length >> (8 * i));
+        }
+    }
+    out.append(payload, length);
+}
+
+bool FakeServer::start(uint16_t port) {
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0) return false;
+    int one = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    socklen_t addrLength = sizeof(addr);
+    if (bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(_fd, 128) != 0 ||
+        getsockname(_fd, (struct sockaddr *)&addr, &addrLength) != 0) {
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+    _port = ntohs(addr.sin_port);
+    _running = true;
+    _acceptThread = std::thread(&FakeServer::acceptLoop, this);
+    return true;
+}
+
+void FakeServer::stop() {
+    if (!_running) return;
+    _running = false;
+    _acceptThread.join();
+    close(_fd);
+    _fd = -1;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &connection : _connections) {
+        connection.join();
+    }
+    _connections.clear();
+}
+
+void FakeServer::acceptLoop() {
+    while (_running) {
+        struct pollfd pfd = { _fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        int fd = accept(_fd, NULL, NULL);
+        if (fd < 0) continue;
+        _accepted++;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connections.push_back(std::thread(&FakeServer::serve, this, fd));
+    }
+}
+
+void FakeServer::serve(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    FakeSession session;
+    uint8_t buffer[4096];
+    std::string out;
+    while (_running && !session.closed()) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, 50);
+        if (ready > 0) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) break;
+            session.receive(buffer, n, out);
+        }
+        session.tick(out);
+        size_t written = 0;
+        while (written < out.size()) {
+            ssize_t w = send(fd, out.data() + written, out.size() - written, MSG_NOSIGNAL);
+            if (w <= 0) break;
+            written += w;
+        }
+        out.clear();
+    }
+    close(fd);
+}
+
+int LoopbackClient::connect(const char *host, uint16_t port) {
+    (void)host;
+    (void)port;
+    stop();
+    _session = new FakeSession();
+    _connected = true;
+    return 1;
+}
+
+size_t LoopbackClient::write(const uint8_t *buf, size_t size) {
+    if (!_connected) return 0;
+    if (size > _limit) {
+        size = _limit;
+    }
+    _written += size;
+    if (!_discard) {
+        _session->receive(buf, size, _rx);
+    }
+    if (_session->closed()) {
+        _connected = false;
+    }
+    return size;
+}
+
+int LoopbackClient::read(uint8_t *buf, size_t size) {
+    size_t n = available();
+    if (n == 0) return -1;
+    if (n > size) n = size;
+    memcpy(buf, &_rx[_position], n);
+    _position += n;
+    if (_position == _rx.size()) {
+        _rx.clear();
+        _position = 0;
+    }
+    return n;
+}
+
+void LoopbackClient::stop() {
+    delete _session;
+    _session = NULL;
+    _connected = false;
+    _rx.clear();
+    _position = 0;
+}
+
+void LoopbackClient::inject(const std::string &bytes) {
+    _rx += bytes;
+}
@@ -0,0 +1,159 @@
+/*
+Stand-in engine.io/socket.io server for host builds: speaks the dialect of
+this library (EIO 3 or 4 long-polling handshake with b64=true, WebSocket
+upgrade and probe, heartbeats, permessage-deflate, text and binary events
+and acks) over loopback TCP or in memory.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _FAKE_SERVER_H
+#define _FAKE_SERVER_H
+
+#include <SocketIOClient.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Server side of one connection, independent of the transport: receive()
+ * consumes what the client wrote and appends the server's answer to out.
+ * Every event with an ack id is acknowledged with its own arguments,
+ * "echo" events are sent back to the client as they came, "kick" events
+ * disconnect their namespace. Events whose name starts with "ask" are sent
+ * back with an ack id, and the arguments of the client's ack come back as
+ * those of an "answer" event. Namespaces are accepted but /private, which
+ * gets a connect error. Binary attachments go back in the form they came
+ * in, frame or base64. With permessage-deflate messages from 64 bytes on
+ * are sent compressed. Sessions asked for with EIO=4 are Socket.IO 3 and
+ * on ones: the server pings, from tick(), and a client ping closes them.
+ */
+class FakeSession {
+public:
+    FakeSession();
+
+    void receive(const uint8_t *data, size_t length, std::string &out);
+    /// Sends the EIO 4 server's ping when it is due
+    void tick(std::string &out);
+    bool closed() const { return _closed; }
+
+    static void appendFrame(std::string &out, const char *payload, size_t length, wsOpcode_t opcode = wsOp_TEXT, bool compressed = false);
+    static void appendFrame(std::string &out, const std::string &payload) { appendFrame(out, payload.data(), payload.size()); }
+
+    static std::atomic<unsigned long> eventsReceived;
+    /// WebSockets are opened without a polling handshake first, 400 Bad Request if false
+    static std::atomic<bool> directWebSocket;
+    /// Closes the connection after the polling response: 0 never, 1 saying so, 2 without saying so
+    static std::atomic<int> closeAfterPolling;
+    /// The heartbeat and limit the open packet announces, maxPayload 0 leaves it out
+    static std::atomic<unsigned long> pingInterval;
+    static std::atomic<unsigned long> pingTimeout;
+    static std::atomic<unsigned long> maxPayload;
+    /// Pings are answered (EIO 3) or sent (EIO 4), false plays a dead server
+    static std::atomic<bool> heartbeat;
+
+private:
+    void handleRequest(std::string &out);
+    void handleMessage(const char *payload, size_t length, std::string &out);
+    void handleEvent(const std::string &packet, std::string &out);
+    void send(std::string &out, const std::string &payload);
+    std::string openPacket();
+
+    std::string _binaryPacket;
+    size_t _attachmentsPending = 0;
+    unsigned long _asked = 0;
+    std::string _attachmentFrames;
+
+    std::string _request;
+    std::string _sid;
+    bool _eio4 = false;
+    unsigned long _lastPing = 0;
+    bool _websocket = false;
+    bool _closed = false;
+    std::vector<uint8_t> _message;
+    WebSocketDecoder _decoder;
+#ifdef SOCKETIO_DEFLATE
+    bool _deflate = false;
+    WebSocketInflater _inflater;
+    WebSocketDeflater _deflater;
+#endif
+};
+
+/// Accepts loopback connections and serves each one with a FakeSession on its own thread
+class FakeServer {
+public:
+    ~FakeServer() { stop(); }
+
+    bool start(uint16_t port = 0);  // 0 picks a free port
+    void stop();
+    uint16_t port() const { return _port; }
+    unsigned long accepted() const { return _accepted; }
+
+private:
+    void acceptLoop();
+    void serve(int fd);
+
+    int _fd = -1;
+    uint16_t _port = 0;
+    std::atomic<bool> _running{false};
+    std::atomic<unsigned long> _accepted{0};
+    std::thread _acceptThread;
+    std::mutex _mutex;
+    std::vector<std::thread> _connections;
+};
+
+/**
+ * Client connected to a FakeSession in memory, without sockets or threads.
+ * inject() queues server frames for the next reads, discardWrites() drops
+ * what the client sends once the handshake is done, limitWrites() makes
+ * write() take at most that many bytes per call, like a full send buffer.
+ */
+class LoopbackClient : public Client {
+public:
+    ~LoopbackClient() { stop(); }
+
+    int connect(const char *host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override { return _rx.size() - _position; }
+    int read() override { return available() ? (uint8_t)_rx[_position++] : -1; }
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override { return available() ? (uint8_t)_rx[_position] : -1; }
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override { return _connected || available(); }
+    using Print::write;
+
+    void inject(const std::string &bytes);
+    void discardWrites(bool discard) { _discard = discard; }
+    void limitWrites(size_t limit) { _limit = limit; }
+    size_t bytesWritten() const { return _written; }
+
+private:
+    FakeSession *_session = NULL;
+    bool _connected = false;
+    bool _discard = false;
+    size_t _limit = SIZE_MAX;
+    size_t _written = 0;
+    std::string _rx;
+    size_t _position = 0;
+};
+
+#endif
@@ -0,0 +1,235 @@
+/*
+Fleet of simulated devices for load tests, host builds only.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <Fleet.h>
+#include <EpollClient.h>
+#include <algorithm>
+#include <memory>
+#include <sys/epoll.h>
+#include <thread>
+#include <unistd.h>
+
+// Every client is swept this often, its loop() less often unless its socket is ready
+static const unsigned long SWEEP_INTERVAL = 5;
+static const unsigned long LOOP_INTERVAL = 50;
+
+struct Fleet::Device {
+    explicit Device(int epoll) : transport(epoll, this) {}
+
+    EpollClient transport;
+    SocketIOClient client;
+    unsigned long startAt = 0;
+    unsigned long lastLoop = 0;
+    bool started = false;
+    bool wasConnected = false;
+    socketIOState_t state = sIOstate_DISCONNECTED;
+    std::vector<unsigned long> nextEmit;
+};
+
+fleetReport_t Fleet::run() {
+    size_t loops = std::max((size_t)1, std::min(_options.loops, _options.clients));
+    std::vector<fleetReport_t> reports(loops);
+    std::vector<std::thread> threads;
+    unsigned long start = millis();
+    for (size_t i = 0; i < loops; i++) {
+        threads.push_back(std::thread(&Fleet::runLoop, this, i, std::ref(reports[i])));
+    }
+    fleetReport_t report;
+    for (size_t i = 0; i < loops; i++) {
+        threads[i].join();
+        report.merge(reports[i]);
+    }
+    report.elapsed = millis() - start;
+    return report;
+}
+
+static std::string jsonOfSize(size_t size) {
+    // {"v":"xxxx"} padded to the requested JSON length
+    std::string payload = "{\"v\":\"";
+    while (payload.size() + 2 < size) payload += 'x';
+    return payload + "\"}";
+}
+
+void Fleet::runLoop(size_t index, fleetReport_t &report) {
+    int epoll = epoll_create1(0);
+    if (epoll < 0) return;
+    size_t loops = std::max((size_t)1, std::min(_options.loops, _options.clients));
+    const std::vector<fleetEmit_t> &script = _options.script;
+    std::vector<std::string> payloads;
+    for (const fleetEmit_t &line : script) {
+        payloads.push_back(jsonOfSize(line.size));
+    }
+    bool stopping = false;
+    // the random() generator is per thread, every loop spreads its clients' emits differently
+    randomSeed(micros() + index);
+
+    unsigned long start = millis();
+    std::vector<std::unique_ptr<Device>> devices;
+    for (size_t i = index; i < _options.clients; i++) {
+        if (i % loops != index) continue;
+        Device *device = new Device(epoll);
+        devices.push_back(std::unique_ptr<Device>(device));
+        device->startAt = _options.ramp * i / _options.clients;
+        device->client.setClient(device->transport);
+        device->client.setBinaryMode(_options.binaryMode);
+        device->client.setConnectMode(_options.connectMode);
+        device->client.setProtocol(_options.protocol);
+        device->client.onStateChange([device, &report, &script, &stopping](socketIOState_t state) {
+            if (stopping) {
+                // the fleet disconnects its clients itself
+            } else if (state == sIOstate_CONNECTED) {
+                report.handshakes.push_back(device->client.handshakeTime());
+                device->wasConnected = true;
+                // spread the scripted emits over their interval
+                device->nextEmit.clear();
+                for (const fleetEmit_t &line : script) {
+                    device->nextEmit.push_back(millis() + random(line.interval));
+                }
+            } else if (state == sIOstate_DISCONNECTED) {
+                if (device->state == sIOstate_CONNECTED) {
+                    report.disconnects++;
+                } else if (device->state != sIOstate_DISCONNECTED) {
+                    report.connectFailures++;
+                }
+            }
+            device->state = state;
+        });
+    }
+    report.clients = devices.size();
+
+    struct epoll_event events[256];
+    unsigned long end = _options.ramp + _options.duration;
+    unsigned long lastSweep = 0;
+    while (millis() - start < end) {
+        int count = epoll_wait(epoll, events, 256, SWEEP_INTERVAL);
+        for (int i = 0; i < count; i++) {
+            Device *device = (Device *)events[i].data.ptr;
+            device->transport.handle(events[i].events);
+            device->client.loop();
+            device->lastLoop = millis();
+        }
+        unsigned long now = millis();
+        if (now - lastSweep < SWEEP_INTERVAL) continue;
+        lastSweep = now;
+        for (auto &entry : devices) {
+            Device &device = *entry;
+            if (!device.started) {
+                if (now - start < device.startAt) continue;
+                device.started = true;
+                device.client.connect(_options.host, _options.port);
+            }
+            if (now - device.lastLoop >= LOOP_INTERVAL) {
+                device.client.loop();
+                device.lastLoop = now;
+            }
+            if (device.client.state() != sIOstate_CONNECTED) continue;
+            for (size_t j = 0; j < script.size(); j++) {
+                const fleetEmit_t &line = script[j];
+                if ((long)(now - device.nextEmit[j]) < 0) continue;
+                device.nextEmit[j] += line.interval;
+                // a client that fell behind skips the emits it missed
+                if ((long)(now - device.nextEmit[j]) > (long)line.interval) {
+                    device.nextEmit[j] = now + line.interval;
+                }
+                report.emits++;
+                bool sent;
+                unsigned long sentAt = micros();
+                if (line.binary) {
+                    binaryAckCallback_fn cb = NULL;
+                    if (line.ack) {
+                        cb = [&report, &stopping, sentAt](const socketIOView_t &payload, const socketIOAttachments_t &attachments) {
+                            if (attachments.count) {
+                                report.acks++;
+                                report.ackLatencies.push_back(micros() - sentAt);
+                            } else if (!stopping) {
+                                report.ackTimeouts++;
+                            }
+                            (void)payload;
+                        };
+                    }
+                    sent = device.client.emitBinary(line.event.c_str(), (const uint8_t *)payloads[j].data(), line.size, cb);
+                } else if (line.ack) {
+                    sent = device.client.emit(line.event.c_str(), payloads[j].c_str(), [&report, &stopping, sentAt](const char *payload) {
+                        if (payload) {
+                            report.acks++;
+                            report.ackLatencies.push_back(micros() - sentAt);
+                        } else if (!stopping) {
+                            report.ackTimeouts++;
+                        }
+                    });
+                } else {
+                    sent = device.client.emit(line.event.c_str(), payloads[j].c_str());
+                }
+                if (!sent) report.emitErrors++;
+            }
+        }
+    }
+
+    // acks still pending when the fleet stops are not counted as timeouts
+    stopping = true;
+    for (auto &entry : devices) {
+        Device &device = *entry;
+        report.connected += device.client.state() == sIOstate_CONNECTED;
+        report.droppedFrames += device.client.droppedFrames();
+        report.bytesQueued += device.transport.queued();
+        device.client.disconnect();
+    }
+    devices.clear();
+    close(epoll);
+}
+
+void fleetReport_t::merge(const fleetReport_t &other) {
+    clients += other.clients;
+    connected += other.connected;
+    connectFailures += other.connectFailures;
+    disconnects += other.disconnects;
+    emits += other.emits;
+    emitErrors += other.emitErrors;
+    acks += other.acks;
+    ackTimeouts += other.ackTimeouts;
+    droppedFrames += other.droppedFrames;
+    bytesQueued += other.bytesQueued;
+    handshakes.insert(handshakes.end(), other.handshakes.begin(), other.handshakes.end());
+    ackLatencies.insert(ackLatencies.end(), other.ackLatencies.begin(), other.ackLatencies.end());
+}
+
+static unsigned long percentile(const std::vector<unsigned long> &sorted, double p) {
+    return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * p))];
+}
+
+void fleetReport_t::print(FILE *out) {
+    std::sort(handshakes.begin(), handshakes.end());
+    std::sort(ackLatencies.begin(), ackLatencies.end());
+    double seconds = elapsed / 1000.0;
+    fprintf(out, "clients    %zu, %zu connected at the end\n", clients, connected);
+    fprintf(out, "handshake  %zu, p50 %lu us, p99 %lu us, max %lu us\n", handshakes.size(),
+        percentile(handshakes, 0.5), percentile(handshakes, 0.99), handshakes.empty() ? 0 : handshakes.back());
+    fprintf(out, "emits      %lu, %.0f/s, %lu refused\n", emits, seconds > 0 ? emits / seconds : 0, emitErrors);
+    fprintf(out, "acks       %lu, p50 %lu us, p99 %lu us, max %lu us, %lu timed out\n", acks,
+        percentile(ackLatencies, 0.5), percentile(ackLatencies, 0.99), ackLatencies.empty() ? 0 : ackLatencies.back(), ackTimeouts);
+    fprintf(out, "errors     %lu connect failures, %lu disconnects, %lu dropped frames, %lu bytes unsent\n",
+        connectFailures, disconnects, droppedFrames, bytesQueued);
+}
+
+bool fleetReport_t::ok() const {
+    return connected == clients && connectFailures == 0 && disconnects == 0 &&
+        emitErrors == 0 && ackTimeouts == 0 && droppedFrames == 0;
+}
@@ -0,0 +1,97 @@
+/*
+Fleet of simulated devices for load tests, host builds only.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _FLEET_H
+#define _FLEET_H
+
+#include <SocketIOClient.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/// A line of the devices' script: every interval ms, emit event with size bytes of data
+struct fleetEmit_t {
+    unsigned long interval = 1000;
+    std::string event = "telemetry";
+    size_t size = 64;
+    bool ack = false;
+    bool binary = false;
+};
+
+struct fleetOptions_t {
+    const char *host = "127.0.0.1";
+    uint16_t port = 3484;
+    size_t clients = 100;
+    /// Threads, each with an epoll set of its share of the clients
+    size_t loops = 1;
+    /// ms the clients take to start connecting, one after the other
+    unsigned long ramp = 1000;
+    /// ms the fleet runs once the last client started
+    unsigned long duration = 5000;
+    socketIOBinaryMode_t binaryMode = sIObinary_NATIVE;
+    socketIOConnectMode_t connectMode = sIOconnect_POLLING;
+    socketIOProtocol_t protocol = sIOprotocol_EIO3;
+    std::vector<fleetEmit_t> script;
+};
+
+/// What the fleet saw, all loops together. Latencies are in us
+struct fleetReport_t {
+    size_t clients = 0;
+    /// Clients connected when the fleet stopped
+    size_t connected = 0;
+    unsigned long connectFailures = 0;
+    unsigned long disconnects = 0;
+    unsigned long emits = 0;
+    /// Emits the client refused: no connection, no ack slot or no room to queue them
+    unsigned long emitErrors = 0;
+    unsigned long acks = 0;
+    unsigned long ackTimeouts = 0;
+    unsigned long droppedFrames = 0;
+    unsigned long bytesQueued = 0;
+    unsigned long elapsed = 0;
+    std::vector<unsigned long> handshakes;
+    std::vector<unsigned long> ackLatencies;
+
+    void merge(const fleetReport_t &other);
+    void print(FILE *out);
+    /// Every client connected and stayed so, every emit went out and was acked in time
+    bool ok() const;
+};
+
+/**
+ * Runs many SocketIOClients, each on an EpollClient, from a few threads:
+ * each loop waits on its epoll set and runs loop() of the clients whose
+ * sockets have something to read or room to write, and sweeps all of them
+ * every few ms for their handshake timers, pings and scripted emits.
+ */
+class Fleet {
+public:
+    explicit Fleet(const fleetOptions_t &options) : _options(options) {}
+    fleetReport_t run();
+
+private:
+    struct Device;
+    void runLoop(size_t index, fleetReport_t &report);
+
+    fleetOptions_t _options;
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+POSIX socket transport for host builds of the Socket.IO client.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <PosixClient.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int PosixClient::connect(const char *host, uint16_t port) {
+    stop();
+
+    struct addrinfo hints;
+    struct addrinfo *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &result) != 0) return 0;
+
+    for (struct addrinfo *ai = result; ai != NULL; ai = ai->ai_next) {
+        _fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (_fd < 0) continue;
+        if (::connect(_fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(_fd);
+        _fd = -1;
+    }
+    freeaddrinfo(result);
+    if (_fd < 0) return 0;
+
+    int one = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    _eof = false;
+    _position = _length = 0;
+    return 1;
+}
+
+size_t PosixClient::write(const uint8_t *buf, size_t size) {
+    size_t written = 0;
+    while (_fd >= 0 && written < size) {
+        ssize_t n = send(_fd, buf + written, size - written, MSG_NOSIGNAL);
+        if (n > 0) {
+            written += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // like the lwIP and W5100 clients, wait for room in the send buffer
+            struct pollfd pfd = { _fd, POLLOUT, 0 };
+            poll(&pfd, 1, 1000);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            _eof = true;
+            break;
+        }
+    }
+    return written;
+}
+
+bool PosixClient::fill() {
+    if (_position < _length) return true;
+    if (_fd < 0 || _eof) return false;
+    ssize_t n = recv(_fd, _buffer, sizeof(_buffer), 0);
+    if (n > 0) {
+        _position = 0;
+        _length = n;
+        return true;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        _eof = true;
+    }
+    return false;
+}
+
+int PosixClient::available() {
+    return fill() ? _length - _position : 0;
+}
+
+int PosixClient::read() {
+    return fill() ? _buffer[_position++] : -1;
+}
+
+int PosixClient::read(uint8_t *buf, size_t size) {
+    if (!fill()) return -1;
+    size_t n = _length - _position;
+    if (n > size) n = size;
+    memcpy(buf, &_buffer[_position], n);
+    _position += n;
+    return n;
+}
+
+int PosixClient::peek() {
+    return fill() ? _buffer[_position] : -1;
+}
+
+void PosixClient::stop() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+    _fd = -1;
+    _position = _length = 0;
+}
+
+uint8_t PosixClient::connected() {
+    fill();
+    return _fd >= 0 && (!_eof || _position < _length);
+}
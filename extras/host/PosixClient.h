@@ -0,0 +1,61 @@
+/*
+POSIX socket transport for host builds of the Socket.IO client.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _POSIX_CLIENT_H
+#define _POSIX_CLIENT_H
+
+#include <Client.h>
+
+/**
+ * Arduino Client over a BSD socket. connect() blocks like the WiFi and
+ * Ethernet clients do, reads never block: available() only reports what
+ * the kernel already received.
+ */
+class PosixClient : public Client {
+public:
+    PosixClient() {}
+    ~PosixClient() { stop(); }
+
+    int connect(const char *host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    using Print::write;
+
+    int fd() const { return _fd; }
+
+private:
+    bool fill();
+
+    int _fd = -1;
+    bool _eof = false;
+    uint8_t _buffer[4096];
+    size_t _position = 0;
+    size_t _length = 0;
+};
+
+#endif
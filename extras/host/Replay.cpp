@@ -0,0 +1,300 @@
+/*
+Replay of the connection captures SocketIOCapture records, host builds only.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <Replay.h>
+#include <chrono>
+#include <ctype.h>
+#include <string.h>
+#include <thread>
+
+static bool isCaptureData(socketIOCaptureType_t type) {
+    return type == sIOcapture_IN || type == sIOcapture_IN_MESSAGE;
+}
+
+// The hex lines of a serial log, decoded
+static std::string fromHex(const std::string &text) {
+    std::string bytes;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) end = text.size();
+        size_t last = end;
+        while (last > start && isspace((unsigned char)text[last - 1])) last--;
+        bool hex = last > start && (last - start) % 2 == 0;
+        for (size_t i = start; hex && i < last; i++) {
+            hex = isxdigit((unsigned char)text[i]);
+        }
+        for (size_t i = start; hex && i < last; i += 2) {
+            bytes += (char)strtoul(text.substr(i, 2).c_str(), NULL, 16);
+        }
+        start = end + 1;
+    }
+    return bytes;
+}
+
+static bool readVarint(const std::string &bytes, size_t &position, unsigned long long &value) {
+    value = 0;
+    for (unsigned int shift = 0; position < bytes.size() && shift < 64; shift += 7) {
+        uint8_t byte = bytes[position++];
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool parseCapture(const std::string &capture, std::vector<replayRecord_t> &records, unsigned long &dropped) {
+    std::string bytes = capture.compare(0, 4, "SIOC") == 0 ? capture : fromHex(capture);
+    if (bytes.size() < 5 || bytes.compare(0, 4, "SIOC") != 0 || bytes[4] != SOCKETIO_CAPTURE_VERSION) return false;
+    size_t position = 5;
+    unsigned long long value;
+    if (!readVarint(bytes, position, value)) return false;
+    dropped = value;
+    records.clear();
+    unsigned long long time = 0;
+    while (position < bytes.size()) {
+        replayRecord_t record;
+        record.type = (socketIOCaptureType_t)bytes[position++];
+        if (!readVarint(bytes, position, value) || bytes.size() - position < 2) break;
+        // the first record's delta is to one that was dropped
+        time += records.empty() ? 0 : value;
+        record.time = time;
+        size_t length = (uint8_t)bytes[position] | (uint8_t)bytes[position + 1] << 8;
+        position += 2;
+        if (bytes.size() - position < length) break;
+        record.data = bytes.substr(position, length);
+        position += length;
+        records.push_back(record);
+    }
+    return true;
+}
+
+ReplayClient::ReplayClient(const std::vector<replayRecord_t> &records, bool realTime) :
+    _records(records), _realTime(realTime) {
+    // a capture that begins with its connection is replayed from there
+    for (_next = 0; _next < _records.size(); _next++) {
+        if (_records[_next].type == sIOcapture_CONNECT) return;
+        if (isCaptureData(_records[_next].type)) break;
+    }
+    _synthetic = true;
+    for (_next = 0; _next < _records.size() && _records[_next].type != sIOcapture_IN_MESSAGE; _next++) {}
+}
+
+int ReplayClient::connect(const char *host, uint16_t port) {
+    _connected = false;
+    if (_synthetic) return _loopback.connect(host, port);
+    while (_next < _records.size() && _records[_next].type != sIOcapture_CONNECT) _next++;
+    if (_next == _records.size()) return 0;
+    if (_start == 0) {
+        _start = micros();
+        _startTime = _records[_next].time;
+    }
+    _next++;
+    _offset = 0;
+    _connected = true;
+    return 1;
+}
+
+void ReplayClient::beginRecorded() {
+    _loopback.stop();
+    _synthetic = false;
+    _connected = true;
+    _offset = 0;
+    _start = micros();
+    _startTime = _next < _records.size() ? _records[_next].time : 0;
+}
+
+unsigned long long ReplayClient::elapsed() const {
+    return micros() - _start + _startTime;
+}
+
+/// Moves on to the record to read from, false if the connection ends before it
+bool ReplayClient::current() {
+    while (_next < _records.size()) {
+        const replayRecord_t &record = _records[_next];
+        if (isCaptureData(record.type)) {
+            if (_offset < record.data.size()) return true;
+        } else if (record.type == sIOcapture_CONNECT || record.type == sIOcapture_CLOSE) {
+            return false;
+        }
+        _next++;
+        _offset = 0;
+    }
+    return false;
+}
+
+unsigned long long ReplayClient::due() {
+    if (!_realTime || _synthetic || _next >= _records.size()) return 0;
+    current();
+    unsigned long long now = elapsed();
+    unsigned long long time = _next < _records.size() ? _records[_next].time : 0;
+    return time > now ? time - now : 0;
+}
+
+int ReplayClient::available() {
+    if (_synthetic) return _loopback.available();
+    if (!_connected || !current() || due()) return 0;
+    return _records[_next].data.size() - _offset;
+}
+
+int ReplayClient::read(uint8_t *buf, size_t size) {
+    if (_synthetic) return _loopback.read(buf, size);
+    size_t n = available();
+    if (n == 0) return -1;
+    if (n > size) n = size;
+    memcpy(buf, &_records[_next].data[_offset], n);
+    _offset += n;
+    _position += n;
+    return n;
+}
+
+int ReplayClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int ReplayClient::peek() {
+    if (_synthetic) return _loopback.peek();
+    return available() ? (uint8_t)_records[_next].data[_offset] : -1;
+}
+
+size_t ReplayClient::write(const uint8_t *buf, size_t size) {
+    if (_synthetic) return _loopback.write(buf, size);
+    return _connected ? size : 0;
+}
+
+void ReplayClient::stop() {
+    _loopback.stop();
+    _connected = false;
+}
+
+uint8_t ReplayClient::connected() {
+    if (_synthetic) return _loopback.connected();
+    if (!_connected) return false;
+    // ends at the close, or the next connection, once it is due in real time
+    return current() || _next == _records.size() || due();
+}
+
+void replayReport_t::add(const socketIOPacketView_t &packet) {
+    events++;
+    for (size_t i = 0; i < packet.event.length; i++) {
+        digest = (digest ^ (uint8_t)packet.event.ptr[i]) * 16777619UL;
+    }
+    digest *= 16777619UL;
+    for (size_t i = 0; i < packet.data.length; i++) {
+        digest = (digest ^ (uint8_t)packet.data.ptr[i]) * 16777619UL;
+    }
+    digest *= 16777619UL;
+}
+
+void replayReport_t::print(FILE *out) const {
+    fprintf(out, "records     %zu, %lu dropped before them%s\n", records, dropped,
+        synthetic ? ", replayed from a message on" : "");
+    fprintf(out, "replayed    %s, %llu bytes in %lu us, %.1f MB/s\n", complete ? "completely" : "INCOMPLETE",
+        bytes, elapsed, elapsed ? (double)bytes / elapsed : 0.0);
+    fprintf(out, "events      %lu, %.0f/s\n", events, elapsed ? events * 1e6 / elapsed : 0.0);
+    fprintf(out, "digest      %08x\n", (unsigned int)digest);
+}
+
+bool SocketIOReplay::load(const std::string &capture) {
+    return parseCapture(capture, _records, _dropped);
+}
+
+void SocketIOReplay::watch(SocketIOClientBase &client, replayReport_t &report, std::function<void (const socketIOPacketView_t &packet)> fn) {
+    client._eventSink = [&report, fn](const socketIOPacketView_t &packet) {
+        report.add(packet);
+        if (fn) fn(packet);
+    };
+}
+
+replayReport_t SocketIOReplay::run(SocketIOClientBase &client, bool realTime) {
+    replayReport_t report;
+    report.records = _records.size();
+    report.dropped = _dropped;
+
+    // the modes the capture was made in, from the client's requests
+    _host = "replay";
+    socketIOConnectMode_t connectMode = sIOconnect_POLLING;
+    socketIOBinaryMode_t binaryMode = sIObinary_NATIVE;
+    socketIOProtocol_t protocol = sIOprotocol_EIO3;
+    bool first = true;
+    for (const replayRecord_t &record : _records) {
+        if (record.type == sIOcapture_CONNECT && first) {
+            _host = record.data.substr(0, record.data.rfind(':'));
+        }
+        if (record.type == sIOcapture_OUT && record.data.compare(0, 15, "GET /socket.io/") == 0 &&
+            record.data.find("EIO=4") < record.data.find("\r\n")) {
+            protocol = sIOprotocol_EIO4;
+        }
+        if (record.type == sIOcapture_OUT && record.data.compare(0, 27, "GET /socket.io/1/websocket/") == 0) {
+            if (first) connectMode = sIOconnect_WEBSOCKET;
+            if (record.data.find("&b64=true") < record.data.find("\r\n")) binaryMode = sIObinary_BASE64;
+            break;
+        }
+        if (record.type == sIOcapture_OUT) first = false;
+    }
+
+    _transport.reset(new ReplayClient(_records, realTime));
+    ReplayClient &transport = *_transport;
+    report.synthetic = transport.synthetic();
+    client.setClient(transport);
+    client.setConnectMode(connectMode);
+    client.setBinaryMode(binaryMode);
+    client.setProtocol(protocol);
+    // the capture goes on with the next connection right away
+    socketIOReconnectPolicy_t policy;
+    policy.initialDelay = 0;
+    policy.jitter = 0;
+    client.setReconnectPolicy(policy);
+    client._eventSink = [this, &report, &transport](const socketIOPacketView_t &packet) {
+        // the stand-in handshake's events are not the capture's
+        if (transport.synthetic()) return;
+        report.add(packet);
+        if (_onEvent) _onEvent(packet);
+    };
+
+    unsigned long start = micros();
+    client.connect(_host.c_str(), 0);
+    unsigned long long position = 0;
+    unsigned long idle = 0;
+    while (!transport.finished() && idle < 10000) {
+        client.loop();
+        if (transport.synthetic() && client.connected() && transport.available() == 0) {
+            transport.beginRecorded();
+        }
+        if (transport.position() != position) {
+            position = transport.position();
+            idle = 0;
+            continue;
+        }
+        unsigned long long due = transport.due();
+        if (due) {
+            std::this_thread::sleep_for(std::chrono::microseconds(std::min(due, 1000ULL)));
+        } else {
+            idle++;
+        }
+    }
+    report.elapsed = micros() - start;
+    report.complete = transport.finished();
+    report.bytes = transport.position();
+    unwatch(client);
+    client.disconnect();
+    return report;
+}
@@ -0,0 +1,156 @@
+/*
+Replay of the connection captures SocketIOCapture records, host builds only.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _REPLAY_H
+#define _REPLAY_H
+
+#include <FakeServer.h>
+#include <functional>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/// A record of a capture, time in us since the first one
+struct replayRecord_t {
+    socketIOCaptureType_t type;
+    unsigned long long time;
+    std::string data;
+};
+
+/**
+ * Parses a capture as dumpCapture() wrote it, as it is or in hex. Lines of
+ * a serial log that are not hex are skipped, a record cut short at the end
+ * is left out.
+ * @return false if it is no capture of a version this build reads
+ */
+bool parseCapture(const std::string &capture, std::vector<replayRecord_t> &records, unsigned long &dropped);
+
+/// Collects what is printed to it, e.g. by dumpCapture()
+class StringPrint : public Print {
+public:
+    size_t write(uint8_t c) override { text += (char)c; return 1; }
+    size_t write(const uint8_t *buffer, size_t size) override { text.append((const char *)buffer, size); return size; }
+    using Print::write;
+    std::string text;
+};
+
+/**
+ * Transport serving the bytes a captured connection read, in the pieces they
+ * were read in, and taking whatever is written. Each CONNECT record begins a
+ * connection, which ends with the next CLOSE or CONNECT record. A capture
+ * whose beginning was dropped starts with a stand-in handshake, see
+ * beginRecorded(), and goes on from the first record read at the start of a
+ * message. In real time reads are held back until as many us passed as
+ * between the first record and theirs.
+ */
+class ReplayClient : public Client {
+public:
+    ReplayClient(const std::vector<replayRecord_t> &records, bool realTime);
+
+    int connect(const char *host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    using Print::write;
+
+    /// The stand-in handshake is done, the recorded messages follow
+    void beginRecorded();
+    bool synthetic() const { return _synthetic; }
+    /// Every record was served
+    bool finished() const { return _next >= _records.size(); }
+    /// Bytes served so far, which tells whether the replay moves on
+    unsigned long long position() const { return _position; }
+    /// us until the next read is due, in real time
+    unsigned long long due();
+
+private:
+    bool current();
+    unsigned long long elapsed() const;
+
+    const std::vector<replayRecord_t> &_records;
+    bool _realTime;
+    bool _synthetic = false;
+    LoopbackClient _loopback;
+    bool _connected = false;
+    size_t _next = 0;
+    size_t _offset = 0;
+    unsigned long long _position = 0;
+    unsigned long _start = 0;
+    unsigned long long _startTime = 0;
+};
+
+/// What a replay dispatched and how fast. The digest is FNV-1a of every event's name and data
+struct replayReport_t {
+    size_t records = 0;
+    unsigned long dropped = 0;
+    bool synthetic = false;
+    /// Every record was served
+    bool complete = false;
+    unsigned long events = 0;
+    uint32_t digest = 2166136261UL;
+    unsigned long long bytes = 0;
+    unsigned long elapsed = 0;
+
+    void add(const socketIOPacketView_t &packet);
+    void print(FILE *out) const;
+};
+
+/**
+ * Feeds a capture through a client's decoder and dispatcher. Events of the
+ * default namespace are reported in place of its handlers, so two builds,
+ * or a build and the device that recorded the capture, can be compared by
+ * their digests. The client keeps the ReplayClient as its transport, the
+ * replay has to outlive it or be followed by setClient().
+ */
+class SocketIOReplay {
+public:
+    bool load(const std::string &capture);
+    const std::vector<replayRecord_t> &records() const { return _records; }
+    unsigned long dropped() const { return _dropped; }
+
+    /**
+     * Connects the client over the capture, in the connect and binary modes
+     * its requests tell, and runs loop() until every record was served, or
+     * nothing moves any more.
+     */
+    replayReport_t run(SocketIOClientBase &client, bool realTime = false);
+    /// Called with the name and data of every event replayed
+    void onEvent(std::function<void (const socketIOPacketView_t &packet)> fn) { _onEvent = fn; }
+    /// Reports the events a live client receives the way run() does, until unwatch()
+    static void watch(SocketIOClientBase &client, replayReport_t &report, std::function<void (const socketIOPacketView_t &packet)> fn = nullptr);
+    static void unwatch(SocketIOClientBase &client) { client._eventSink = nullptr; }
+
+private:
+    std::vector<replayRecord_t> _records;
+    unsigned long _dropped = 0;
+    std::string _host;
+    std::unique_ptr<ReplayClient> _transport;
+    std::function<void (const socketIOPacketView_t &packet)> _onEvent;
+};
+
+#endif
@@ -0,0 +1,1345 @@
+/*
+Throughput and latency of the client hot paths at different payload sizes:
+parse() on its own and with a field read by the JSON cursor, parser() dispatch of received frames and emit() over an
+in-memory connection, and ack round trips through the loopback server, for
+text events and for binary events sent as frames or base64.
+Usage: socketio_bench [--quick] [--list] [feature...]
+Without features named, all of them run.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <FakeServer.h>
+#include <Replay.h>
+#include <SocketIOTask.h>
+#ifdef SOCKETIO_DEFLATE
+#include <DeflateVectors.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <thread>
+
+typedef std::chrono::steady_clock benchClock;
+
+static size_t iterations = 200000;
+static bool failed = false;
+static const char *currentFeature = "";
+
+// operator new calls of this thread, the server's threads allocate as they like
+static thread_local size_t allocations = 0;
+
+// both kept out of line, inlined GCC takes the new-expressions for malloc() and their deletes for free()
+__attribute__((noinline)) void *operator new(size_t size) {
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    free(p);
+}
+
+static std::string payloadOfSize(size_t size) {
+    // {"v":"xxxx"} padded to the requested JSON length
+    std::string payload = "{\"v\":\"";
+    while (payload.size() + 2 < size) payload += 'x';
+    return payload + "\"}";
+}
+
+template <typename F>
+static void measure(const char *name, size_t size, size_t count, F fn) {
+    std::vector<uint32_t> samples;
+    samples.reserve(count);
+    benchClock::time_point begin = benchClock::now();
+    for (size_t i = 0; i < count; i++) {
+        benchClock::time_point start = benchClock::now();
+        fn();
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(benchClock::now() - start).count());
+    }
+    double seconds = std::chrono::duration<double>(benchClock::now() - begin).count();
+    std::sort(samples.begin(), samples.end());
+    printf("%-10s %6zu %12.0f %10u %10u\n", name, size, count / seconds,
+        samples[samples.size() / 2], samples[samples.size() * 99 / 100]);
+}
+
+static void check(bool condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s: %s\n", currentFeature, what);
+        failed = true;
+    }
+}
+
+static bool waitConnected(SocketIOClientBase &client, unsigned long timeout = 5000) {
+    unsigned long start = millis();
+    while (!client.connected() && millis() - start < timeout) {
+        client.loop();
+    }
+    return client.connected();
+}
+
+/**
+ * The client of a check, on a FakeSession in memory, or on the stand-in
+ * server if given one. Handlers and policies are set before connect(),
+ * which checks the handshake.
+ */
+class benchClient_t {
+public:
+    explicit benchClient_t(FakeServer *server = NULL) : client(new SocketIOClient()), _server(server) {
+        if (server == NULL) {
+            client->setClient(loopback);
+        }
+    }
+
+    bool connect() {
+        if (_server) {
+            client->connect("127.0.0.1", _server->port());
+        } else {
+            client->connect("loopback", 0);
+        }
+        bool connected = waitConnected(*client);
+        check(connected, _server ? "loopback server handshake" : "loopback handshake");
+        return connected;
+    }
+
+    SocketIOClient *operator->() const { return client.get(); }
+    SocketIOClient &operator*() const { return *client; }
+
+    LoopbackClient loopback;
+    std::unique_ptr<SocketIOClient> client;
+
+private:
+    FakeServer *_server;
+};
+
+static void benchParse(size_t size) {
+    std::string packet = "[\"bench\"," + payloadOfSize(size) + "]";
+    socketIOPacketView_t view;
+    bool ok = true;
+    measure("parse", size, iterations, [&]() {
+        ok &= SocketIOClient::parse(sIOtype_EVENT, packet.data(), packet.size(), view);
+    });
+    check(ok && view.data.length == size, "parse()");
+}
+
+static void benchCursor(size_t size) {
+    // the field read last in the payload, behind a padding member
+    std::string padding = payloadOfSize(size);
+    std::string packet = "[\"bench\"," + padding.substr(0, padding.size() - 1) + ",\"sensor\":{\"temp\":21.5}}]";
+    socketIOPacketView_t view;
+    double sum = 0;
+    size_t allocated = 0;
+    measure("cursor", size, iterations, [&]() {
+        size_t before = allocations;
+        SocketIOClient::parse(sIOtype_EVENT, packet.data(), packet.size(), view);
+        sum += view.data.json().get("sensor.temp").asDouble();
+        allocated += allocations - before;
+    });
+    check(allocated == 0, "cursor does not allocate");
+    check(sum == 21.5 * iterations, "cursor get()");
+}
+
+static void checkCursor() {
+    const char *payload = "{\"id\":\"a\\\"b\\u00e9\\ud83d\\ude00\", \"n\" : -42, \"f\":1.5e3, \"ok\":true,"
+        " \"none\":null, \"list\":[1,[2,\"]\"],{\"x\":3}], \"empty\":{}},7,\"last\"";
+    socketIOView_t data = {payload, strlen(payload)};
+    socketIOJsonCursor_t json = data.json();
+    check(json.type() == sIOjson_OBJECT && json.size() == 7, "cursor object");
+    char text[16];
+    check(json["id"].asString(text, sizeof(text)) == 9 && strcmp(text, "a\"b\xc3\xa9\xf0\x9f\x98\x80") == 0,
+        "cursor unescapes strings");
+    check(json["id"].equals("a\"b\xc3\xa9\xf0\x9f\x98\x80") && !json["id"].equals("a\"b"), "cursor equals()");
+    check(json["id"].asString(text, 3) == 9 && strcmp(text, "a\"") == 0, "cursor truncates strings");
+    check(json["n"].asLong() == -42 && json["f"].asLong() == 1500 && json["f"].asDouble() == 1500.0, "cursor numbers");
+    check(json["ok"].asBool() && json["none"].isNull() && json["n"].asBool(true), "cursor literals");
+    check(json.get("list.1.1").equals("]") && json.get("list.2.x").asLong() == 3, "cursor paths");
+    check(json.get("list.3").type() == sIOjson_MISSING && json.get("missing.x").asLong(-1) == -1, "cursor missing");
+    check(json["empty"].type() == sIOjson_OBJECT && !json["empty"].first().exists(), "cursor empty object");
+
+    long sum = 0;
+    for (socketIOJsonCursor_t item = json["list"].first(); item.exists(); item = item.next()) {
+        sum += item.type() == sIOjson_NUMBER ? item.asLong() : item.size();
+    }
+    check(sum == 4, "cursor iteration");
+    socketIOJsonCursor_t member = json.first().next();
+    check(member.key().equals("n") && member.asLong() == -42, "cursor member keys");
+    check(data.arg(1).asLong() == 7 && data.arg(2).equals("last") && !data.arg(3).exists(), "cursor arguments");
+
+    socketIOJsonCursor_t broken("{\"a\":[1,2}", 11);
+    check(!broken.exists() && broken["a"].asLong(5) == 5, "cursor malformed");
+    socketIOJsonCursor_t number("12", 2);
+    check(number.asULong() == 12 && number.asFloat() == 12.0f, "cursor unterminated number");
+}
+
+static void benchParser(size_t size) {
+    benchClient_t client;
+    unsigned long received = 0;
+    client->on("bench", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        received += data.length == size;
+    });
+    client.connect();
+
+    std::string frame;
+    FakeSession::appendFrame(frame, "42[\"bench\"," + payloadOfSize(size) + "]");
+    measure("parser", size, iterations, [&]() {
+        client.loopback.inject(frame);
+        client->loop();
+    });
+    check(received == iterations, "parser() dispatch");
+}
+
+static void checkControlFrames() {
+    // a WebSocket ping is answered at once, whatever the flush policy holds back
+    benchClient_t client;
+    client.connect();
+    socketIOFlushPolicy_t policy;
+    policy.maxFrames = 100;
+    policy.maxDelay = 10000;
+    client->setFlushPolicy(policy);
+    client->emit("bench", "1");
+    std::string ping;
+    FakeSession::appendFrame(ping, "beat", 4, wsOp_PING);
+    size_t before = client.loopback.bytesWritten();
+    client.loopback.inject(ping);
+    client->loop();
+    check(client->queuedBytes() == 0 && client.loopback.bytesWritten() > before, "WebSocket pong flushed");
+}
+
+static void checkHandlers() {
+    // on() replaces the handler of an event, whatever kind of callback it had
+    benchClient_t client;
+    int strings = 0, views = 0;
+    client->on("bench", [&](const String &, ackCallback_fn) { strings++; });
+    client->on("bench", [&](const socketIOView_t &, const socketIOAck_t &) { views++; });
+    client.connect();
+    std::string frame;
+    FakeSession::appendFrame(frame, "42[\"bench\",1]");
+    client.loopback.inject(frame);
+    client->loop();
+    check(strings == 0 && views == 1, "on() replaces a handler of another kind");
+
+    // a handler may add handlers, moving the table the running one sits in
+    static const char *const names[] = {"a0", "a1", "a2", "a3", "a4", "a5",
+                                        "b0", "b1", "b2", "b3", "b4", "b5"};
+    std::string captured(64, 'x');
+    int added = 0, calls = 0;
+    client->on("grow", [&, captured](const socketIOView_t &, const socketIOAck_t &) {
+        for (const char *name : names) {
+            added += client->on(name, [&](const socketIOView_t &, const socketIOAck_t &) { calls++; });
+        }
+        check(captured == std::string(64, 'x'), "captures of a handler adding handlers");
+    });
+    frame.clear();
+    FakeSession::appendFrame(frame, "42[\"grow\"]");
+    FakeSession::appendFrame(frame, "42[\"grow\"]");
+    FakeSession::appendFrame(frame, "42[\"b5\"]");
+    client.loopback.inject(frame);
+    for (int i = 0; i < 5; i++) client->loop();
+    check(added == 24 && calls == 1, "handlers added from a handler");
+}
+
+static void benchStream(size_t size) {
+    benchClient_t client;
+    std::string data;
+    size_t largest = 0;
+    size_t ended = 0;
+    client->on("bench", [&](socketIOStreamPhase_t phase, const char *chunk, size_t length) {
+        if (phase == sIOstream_BEGIN) data.clear();
+        if (phase == sIOstream_DATA) data.append(chunk, length);
+        if (phase == sIOstream_END) ended++;
+        largest = std::max(largest, length);
+    });
+    client.connect();
+
+    // the second half as a continuation frame
+    std::string payload = payloadOfSize(size);
+    std::string packet = "42[\"bench\"," + payload + "]";
+    std::string frame;
+    FakeSession::appendFrame(frame, packet.data(), packet.size() / 2, wsOp_TEXT);
+    frame[0] &= 0x7F;
+    FakeSession::appendFrame(frame, &packet[packet.size() / 2], packet.size() - packet.size() / 2, wsOp_CONTINUATION);
+    size_t count = std::max<size_t>(10, std::min<size_t>(iterations, iterations * 256 / size));
+    measure("stream", size, count, [&]() {
+        client.loopback.inject(frame);
+        client->loop();
+    });
+    check(ended == count && data == payload && largest < DATA_BUFFER_LEN, "streamed events");
+
+    // a lost connection aborts the event being streamed
+    if (size < 2 * DATA_BUFFER_LEN) return;
+    bool aborted = false;
+    client->on("bench", [&](socketIOStreamPhase_t phase, const char *, size_t) {
+        aborted |= phase == sIOstream_ABORT;
+    });
+    client.loopback.inject(frame.substr(0, frame.size() / 2));
+    client->loop();
+    client->disconnect();
+    check(aborted, "streamed event aborted");
+}
+
+static void benchEmit(size_t size) {
+    benchClient_t client;
+    client.connect();
+
+    client.loopback.discardWrites(true);
+    size_t before = client.loopback.bytesWritten();
+    std::string payload = payloadOfSize(size);
+    measure("emit", size, iterations, [&]() {
+        client->emit("bench", payload.c_str());
+    });
+    check(client.loopback.bytesWritten() - before >= iterations * (size + 10), "emit() output");
+}
+
+static void benchEmitTyped(size_t size) {
+    benchClient_t client;
+    client.connect();
+
+    client.loopback.discardWrites(true);
+    size_t before = client.loopback.bytesWritten();
+    std::string payload = payloadOfSize(size);
+    measure("emit typed", size, iterations, [&]() {
+        client->emitArgs(SOCKETIO_EVENT("bench"), 42, 21.5f, true, payload.c_str());
+    });
+    check(client.loopback.bytesWritten() - before >= iterations * (size + 10), "emitArgs() output");
+}
+
+struct point_t {
+    int x, y;
+};
+
+template <>
+struct socketIOJson<point_t> {
+    static void write(socketIOJsonWriter_t &out, const point_t &p) {
+        out.raw("{\"x\":");
+        out.number((long)p.x);
+        out.raw(",\"y\":");
+        out.number((long)p.y);
+        out.raw("}");
+    }
+};
+
+static void checkTypedEmit() {
+    benchClient_t client;
+    std::string received;
+    client->on("echo", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        received += std::string(data.ptr, data.length) + ";";
+    });
+    client.connect();
+
+    const char *none = NULL;
+    String text("a \"quoted\"\tline\n");
+    check(client->emitArgs("echo", -12, 4000000000UL, (short)7), "emitArgs() of integers");
+    client->emitArgs("echo", 0.5, 1.25f, 3.0, true, false);
+    client->emitArgs("echo", "he said \"hi\" \\ \x01", none, nullptr);
+    client->emitArgs("echo", text, socketIORawJson_t("{\"n\":[1,2]}"));
+    client->emitArgs(SOCKETIO_EVENT("echo"), point_t{ 3, -4 });
+    client->emitArgs(SOCKETIO_EVENT("echo"));
+    client->emit("echo", "plain");
+    client->emit("echo", "{\"legacy\":1}", [](const char *) {});
+    client->emit("echo", NULL);
+    // a lone int or long, whichever NULL is, is a number here on every target
+    int count = 5;
+    client->emitArgs("echo", count);
+    client->emitArgs("echo", 6L);
+    const char *expected = "-12,4000000000,7;"
+        "0.5,1.25,3,true,false;"
+        "\"he said \\\"hi\\\" \\\\ \\u0001\",null,null;"
+        "\"a \\\"quoted\\\"\\tline\\n\",{\"n\":[1,2]};"
+        "{\"x\":3,\"y\":-4};"
+        ";"
+        "\"plain\";"
+        "{\"legacy\":1};"
+        ";"
+        "5;"
+        "6;";
+    unsigned long start = millis();
+    while (received.size() < strlen(expected) && millis() - start < 1000) {
+        client->loop();
+    }
+    check(received == expected, "emitArgs() serialization");
+    if (received != expected) fprintf(stderr, "  got %s\n", received.c_str());
+
+    // too long for the transmit buffer, dropped rather than cut short
+    std::string payload = payloadOfSize(TX_BUFFER_LEN);
+    check(!client->emitArgs("echo", payload.c_str(), 1), "emitArgs() longer than the transmit buffer");
+}
+
+static void benchEmitBinary(size_t size) {
+    benchClient_t client;
+    client.connect();
+
+    client.loopback.discardWrites(true);
+    size_t before = client.loopback.bytesWritten();
+    std::vector<uint8_t> data(size, 0xA5);
+    measure("emit bin", size, iterations, [&]() {
+        client->emitBinary("bench", data.data(), data.size());
+    });
+    check(client.loopback.bytesWritten() - before >= iterations * (size + 40), "emitBinary() output");
+}
+
+static void benchBinaryAck(FakeServer &server, size_t size, socketIOBinaryMode_t mode) {
+    benchClient_t client(&server);
+    client->setBinaryMode(mode);
+    client.connect();
+
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) data[i] = i * 7;
+    size_t count = iterations / 20;
+    size_t acked = 0;
+    measure(mode == sIObinary_NATIVE ? "bin rtt" : "b64 rtt", size, count, [&]() {
+        bool done = false;
+        client->emitBinary("bench", data.data(), data.size(), [&](const socketIOView_t &, const socketIOAttachments_t &attachments) {
+            done = true;
+            acked += attachments.count == 1 && attachments.length[0] == size &&
+                memcmp(attachments.data[0], data.data(), size) == 0;
+        });
+        unsigned long start = millis();
+        while (!done && millis() - start < 1000) {
+            client->loop();
+        }
+    });
+    check(acked == count, "binary ack round trips");
+    client->disconnect();
+}
+
+static void benchAck(FakeServer &server, size_t size) {
+    benchClient_t client(&server);
+    client.connect();
+
+    std::string payload = payloadOfSize(size);
+    size_t count = iterations / 20;
+    size_t acked = 0;
+    measure("ack rtt", size, count, [&]() {
+        bool done = false;
+        client->emit("bench", payload.c_str(), [&](const char *data) {
+            done = true;
+            acked += strlen(data) == size;
+        });
+        unsigned long start = millis();
+        while (!done && millis() - start < 1000) {
+            client->loop();
+        }
+    });
+    check(acked == count, "ack round trips");
+    client->disconnect();
+}
+
+static void benchConnect(FakeServer &server, socketIOConnectMode_t mode) {
+    // time to connected, a connection and a TLS handshake less makes more of a difference on a device
+    std::unique_ptr<SocketIOClient> client(new SocketIOClient());
+    client->setConnectMode(mode);
+    size_t count = std::min(iterations / 100, (size_t)200);
+    size_t connected = 0;
+    measure(mode == sIOconnect_WEBSOCKET ? "connect ws" : "connect poll", 0, count, [&]() {
+        client->connect("127.0.0.1", server.port());
+        connected += waitConnected(*client) && client->handshakeTime() > 0;
+        client->disconnect();
+    });
+    check(connected == count && client->connectMode() == mode, "handshakes");
+}
+
+static void checkDirectWebSocket(FakeServer &server) {
+    // a direct WebSocket gets its session from the first frame and works as an upgraded one
+    std::unique_ptr<SocketIOClient> client(new SocketIOClient());
+    client->setConnectMode(sIOconnect_WEBSOCKET);
+    std::vector<socketIOState_t> states;
+    client->onStateChange([&](socketIOState_t state) { states.push_back(state); });
+    client->connect("127.0.0.1", server.port());
+    check(waitConnected(*client), "direct WebSocket handshake");
+    check(states.size() == 4 && states[1] == sIOstate_UPGRADING && states[2] == sIOstate_OPENING,
+        "direct WebSocket skips polling and probing");
+    bool acked = false;
+    client->emit("direct", "{}", [&](const char *data) { acked = data != NULL; });
+    unsigned long start = millis();
+    while (!acked && millis() - start < 1000) client->loop();
+    check(acked, "direct WebSocket ack");
+    client->disconnect();
+
+    // a server that wants a polling handshake first gets one, on this and later connections
+    FakeSession::directWebSocket = false;
+    states.clear();
+    client->connect("127.0.0.1", server.port());
+    check(waitConnected(*client), "fallback to polling");
+    check(client->connectMode() == sIOconnect_POLLING &&
+        std::find(states.begin(), states.end(), sIOstate_POLLING) != states.end(), "fallback handshake");
+    client->disconnect();
+    FakeSession::directWebSocket = true;
+}
+
+static void checkDefaultNamespace(FakeServer &server) {
+    // one "connect" per handshake: in the EIO 3 polling body, on an EIO 3 WebSocket, answering EIO 4's 40
+    for (socketIOProtocol_t protocol : { sIOprotocol_EIO3, sIOprotocol_EIO4 }) {
+        for (socketIOConnectMode_t mode : { sIOconnect_POLLING, sIOconnect_WEBSOCKET }) {
+            benchClient_t client(&server);
+            client->setProtocol(protocol);
+            client->setConnectMode(mode);
+            int connects = 0;
+            client->on("connect", [&](const socketIOView_t &, const socketIOAck_t &) { connects++; });
+            client.connect();
+            unsigned long start = millis();
+            while (millis() - start < 100) client->loop();
+            check(connects == 1, protocol == sIOprotocol_EIO4 ? "EIO 4 default namespace" : "EIO 3 default namespace");
+            client->disconnect();
+        }
+    }
+}
+
+static void checkBegin(FakeServer &server) {
+    // begin() alone arms the connection, loop() makes it and disconnect() disarms it
+    std::unique_ptr<SocketIOClient> client(new SocketIOClient());
+    client->begin("127.0.0.1", server.port());
+    check(waitConnected(*client), "begin() and loop() connect");
+    client->disconnect();
+    check(!waitConnected(*client, 200), "no connection after disconnect()");
+}
+
+// Runs the client for ms, @return when it lost the connection, or ms
+static unsigned long runFor(SocketIOClientBase &client, unsigned long ms) {
+    unsigned long start = millis();
+    while (client.connected() && millis() - start < ms) {
+        client.loop();
+    }
+    return millis() - start;
+}
+
+static void checkHeartbeat(FakeServer &server) {
+    // the heartbeat of the open packet, a dead server is dropped after pingInterval + pingTimeout
+    FakeSession::pingInterval = 100;
+    FakeSession::pingTimeout = 400;
+    for (socketIOProtocol_t protocol : { sIOprotocol_EIO3, sIOprotocol_EIO4 }) {
+        for (socketIOConnectMode_t mode : { sIOconnect_POLLING, sIOconnect_WEBSOCKET }) {
+            benchClient_t client(&server);
+            client->setProtocol(protocol);
+            client->setConnectMode(mode);
+            FakeSession::heartbeat = true;
+            client.connect();
+            check(client->pingInterval() == 100 && client->pingTimeout() == 400 && client->maxPayload() == 0,
+                "open packet heartbeat");
+            bool acked = false;
+            client->emit("beat", "{}", [&](const char *data) { acked = data != NULL; });
+            // EIO 4 sessions are closed by a client ping, EIO 3 ones by a missed one
+            runFor(*client, 700);
+            check(client->connected() && acked, protocol == sIOprotocol_EIO4 ? "EIO 4 pongs" : "EIO 3 pings");
+            // the server falls silent once it answered, so the ack is the last
+            // thing the client hears, 1 ms of millis() rounding before it at most
+            unsigned long silent = 0;
+            client->emit("beat", "{}", [&](const char *) {
+                FakeSession::heartbeat = false;
+                silent = millis();
+            });
+            runFor(*client, 2000);
+            unsigned long lost = millis() - silent;
+            // loop() runs back to back here, the 50 ms cover a descheduled process on a loaded host
+            check(!client->connected() && silent && lost >= 499 && lost < 500 + 50, "ping timeout");
+            client->disconnect();
+        }
+    }
+    FakeSession::heartbeat = true;
+    FakeSession::pingInterval = 25000;
+    FakeSession::pingTimeout = 5000;
+
+    // EIO 4 binary attachments, without their engine.io type
+    for (socketIOBinaryMode_t mode : { sIObinary_NATIVE, sIObinary_BASE64 }) {
+        benchClient_t client(&server);
+        client->setProtocol(sIOprotocol_EIO4);
+        client->setBinaryMode(mode);
+        client.connect();
+        const uint8_t data[3] = { 4, 0, 255 };
+        bool acked = false;
+        client->emitBinary("bin", data, sizeof(data), [&](const socketIOView_t &, const socketIOAttachments_t &attachments) {
+            acked = attachments.count == 1 && attachments.length[0] == 3 && memcmp(attachments.data[0], data, 3) == 0;
+        });
+        unsigned long start = millis();
+        while (!acked && millis() - start < 1000) client->loop();
+        check(acked, "EIO 4 binary ack");
+        client->disconnect();
+    }
+
+    // messages the server would not take are dropped before they go out
+    FakeSession::maxPayload = 64;
+    benchClient_t client(&server);
+    client.connect();
+    std::string payload = payloadOfSize(100);
+    uint8_t data[100] = {};
+    unsigned long dropped = client->droppedFrames();
+    check(client->maxPayload() == 64 && !client->emit("big", payload.c_str()) &&
+        !client->emitBinary("big", data, sizeof(data)) && client->emit("small", "1"), "maxPayload");
+    check(client->droppedFrames() - dropped == 3, "maxPayload drops");
+    client->disconnect();
+    FakeSession::maxPayload = 0;
+}
+
+static void checkTransport(FakeServer &server) {
+    // the upgrade reuses the polling connection, unless the server closes it
+    std::unique_ptr<SocketIOClient> client(new SocketIOClient());
+    const int closes[] = { 0, 1, 2 };
+    const unsigned long connections[] = { 1, 2, 2 };
+    for (int i = 0; i < 3; i++) {
+        FakeSession::closeAfterPolling = closes[i];
+        unsigned long accepted = server.accepted();
+        client->connect("127.0.0.1", server.port(), sIOtransport_PLAIN);
+        check(waitConnected(*client), "handshake after the polling connection closed");
+        check(server.accepted() - accepted == connections[i], "connections per handshake");
+#ifdef SOCKETIO_STATS
+        check(client->stats().transportConnects == server.accepted() - accepted, "transport connects");
+        client->resetStats();
+#endif
+        client->disconnect();
+    }
+    FakeSession::closeAfterPolling = 0;
+
+    // no TLS on the host's default transport
+    check(!client->connect("127.0.0.1", server.port(), sIOtransport_TLS) &&
+        client->state() == sIOstate_DISCONNECTED, "TLS refused without a secure transport");
+    client->loop();
+    check(client->state() == sIOstate_DISCONNECTED && client->reconnectAttempts() == 0, "no reconnects without TLS");
+}
+
+static void checkRing() {
+    // records of every length wrap around the end of the ring, in order and intact
+    std::unique_ptr<SocketIORing<256>> ring(new SocketIORing<256>());
+    const size_t count = 20000;
+    std::thread producer([&]() {
+        uint8_t record[100];
+        for (size_t i = 0; i < count; i++) {
+            size_t length = i % sizeof(record);
+            memset(record, (uint8_t)i, length);
+            while (!ring->push(&i, sizeof(i), record, length)) {
+                yield();
+            }
+        }
+    });
+    bool intact = true;
+    uint8_t record[sizeof(size_t) + 100];
+    for (size_t i = 0; i < count;) {
+        size_t length, index;
+        if (!ring->pop(record, sizeof(record), length)) {
+            yield();
+            continue;
+        }
+        memcpy(&index, record, sizeof(index));
+        intact = index == i && length == sizeof(index) + i % 100;
+        for (size_t j = sizeof(index); j < length; j++) intact = intact && record[j] == (uint8_t)i;
+        i++;
+    }
+    producer.join();
+    check(intact && ring->empty(), "SPSC ring");
+}
+
+static void benchTask(FakeServer &server, size_t size) {
+    std::unique_ptr<SocketIOClient> client(new SocketIOClient());
+    std::unique_ptr<SocketIOTask> task(new SocketIOTask(*client));
+    size_t received = 0;
+    std::string last;
+    task->on("echo", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        received++;
+        last.assign(data.ptr, data.length);
+    });
+    check(task->start("127.0.0.1", server.port()), "I/O task start");
+    unsigned long start = millis();
+    while (!task->connected() && millis() - start < 5000) {
+        task->poll();
+        delay(1);
+    }
+    check(task->connected(), "I/O task handshake");
+
+    // round trips through both rings and the I/O task
+    std::string payload = payloadOfSize(size);
+    size_t count = std::max((size_t)20, iterations / 1000);
+    measure("task rtt", size, count, [&]() {
+        size_t before = received;
+        task->emit("echo", payload.c_str());
+        unsigned long start = millis();
+        while (received == before && millis() - start < 1000) {
+            task->poll();
+        }
+    });
+    check(received == count && last == payload, "I/O task round trips");
+
+    // the task keeps reading while the application is busy, the events wait in the ring
+    for (int i = 0; i < 10; i++) task->emitArgs("echo", i, "typed");
+    delay(50);
+    check(task->poll(4) == 4 && task->poll() == 6 && last == "9,\"typed\"" && task->droppedEvents() == 0, "I/O task events queued");
+    task->stop();
+    check(client->state() == sIOstate_DISCONNECTED && !task->connected(), "I/O task stop");
+}
+
+static void checkTaskBacklog(FakeServer &server) {
+    // packets emitted before there is a connection wait in the ring, not only in the offline buffer
+    typedef SocketIOClientT<256, 384, 4, 2> SmallClient;
+    std::unique_ptr<SmallClient> client(new SmallClient());
+    std::unique_ptr<SocketIOTaskT<256, 384>> task(new SocketIOTaskT<256, 384>(*client));
+    std::string received;
+    task->on("echo", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        received.append(data.ptr, data.length);
+    });
+    bool queued = true;
+    for (int i = 0; i < 5; i++) queued &= task->emitArgs("echo", i, i);
+    // the scratch buffers are the client's size
+    check(!task->emit("echo", payloadOfSize(300).c_str()), "I/O task packet longer than the client's buffers");
+    check(queued && task->start("127.0.0.1", server.port()), "I/O task start");
+    unsigned long start = millis();
+    while (received.size() < 15 && millis() - start < 5000) {
+        task->poll();
+        delay(1);
+    }
+    check(received == "0,01,12,23,34,4" && task->droppedEmits() == 0, "I/O task packets emitted before connecting");
+    task->stop();
+}
+
+static void checkStaticFootprint(FakeServer &server) {
+    // a small client: what it takes is known at compile time and it does not allocate once built
+    typedef SocketIOClientT<256, 384, 4, 2> SmallClient;
+    static_assert(SmallClient::footprint().total == sizeof(SmallClient), "footprint() counts the whole client");
+    static_assert(SmallClient::footprint().total < SocketIOClient::footprint().total, "smaller buffers and tables");
+    std::unique_ptr<SmallClient> client(new SmallClient());
+    size_t received = 0;
+    client->on("echo", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        received += data.length > 0;
+    });
+    client->connect("127.0.0.1", server.port());
+    check(waitConnected(*client), "small client handshake");
+
+    size_t acked = 0;
+    size_t before = allocations;
+    for (size_t i = 0; i < 100; i++) {
+        client->emit("echo", "{\"v\":1}", [&](const char *data) { acked += data != NULL; });
+        unsigned long start = millis();
+        while ((acked <= i || received <= i) && millis() - start < 1000) client->loop();
+    }
+    check(acked == 100 && received == 100, "small client events and acks");
+    check(allocations == before, "no allocation once connected");
+    client->disconnect();
+
+    socketIOFootprint_t footprint = SocketIOClient::footprint();
+    printf("%-10s %6zu   rx %zu, tx %zu, handlers %zu, acks %zu\n", "footprint", footprint.total,
+        footprint.rx, footprint.tx, footprint.handlers, footprint.acks);
+}
+
+static void checkAckReplies() {
+    // acks the server asks for carry the arguments alone, 43id[payload], not the event name
+    benchClient_t client;
+    const uint8_t bytes[3] = { 1, 2, 3 };
+    client->on("ask", [&](const socketIOView_t &data, const socketIOAck_t &ack) {
+        if (data.equals("\"binary\"")) {
+            ack(bytes, sizeof(bytes));
+        } else {
+            ack("{\"v\":1}");
+        }
+    });
+    client->on("askString", [](const String &, ackCallback_fn ack) { ack("ok"); });
+    std::vector<std::string> answers;
+    client->on("answer", [&](const socketIOView_t &data, const socketIOAttachments_t &attachments, const socketIOAck_t &) {
+        std::string answer(data.ptr, data.length);
+        if (attachments.count == 1 && attachments.length[0] == 3 && memcmp(attachments.data[0], bytes, 3) == 0) {
+            answer += "+bytes";
+        }
+        answers.push_back(answer);
+    });
+    client.connect();
+    client->emit("ask", "text");
+    client->emit("askString", "text");
+    client->emit("ask", "binary");
+    unsigned long start = millis();
+    while (answers.size() < 3 && millis() - start < 1000) client->loop();
+    check(answers.size() == 3 && answers[0] == "{\"v\":1}" && answers[1] == "\"ok\"" &&
+        answers[2] == "{\"_placeholder\":true,\"num\":0}+bytes", "ack replies");
+}
+
+static void checkAckTable() {
+    benchClient_t client;
+    client.connect();
+    client.loopback.discardWrites(true);
+
+    socketIOAckPolicy_t policy;
+    policy.timeout = 20;
+    client->setAckPolicy(policy);
+    size_t expired = 0;
+    auto cb = [&](const char *data) { expired += data == NULL; };
+    bool sent = true;
+    for (size_t i = 0; i < SOCKETIO_MAX_ACKS; i++) sent &= client->emit("bench", "1", cb);
+    check(sent && !client->emit("bench", "1", cb), "full ack table rejects emit()");
+    unsigned long start = millis();
+    while (client->pendingAcks() && millis() - start < 1000) {
+        client->loop();
+    }
+    check(expired == SOCKETIO_MAX_ACKS, "ack timeouts");
+
+    policy.timeout = 0;
+    policy.evictOldest = true;
+    client->setAckPolicy(policy);
+    expired = 0;
+    for (size_t i = 0; i <= SOCKETIO_MAX_ACKS; i++) sent &= client->emit("bench", "1", cb);
+    check(sent && expired == 1 && client->pendingAcks() == SOCKETIO_MAX_ACKS, "full ack table evicts the oldest");
+    client->disconnect();
+    check(expired == SOCKETIO_MAX_ACKS + 1 && client->pendingAcks() == 0, "acks expire on disconnect()");
+}
+
+static void checkBackpressure() {
+    benchClient_t client;
+#ifdef SOCKETIO_DEFLATE
+    // sizes are those of the frames, and an echo has to be inflated whole
+    socketIOCompression_t uncompressed;
+    uncompressed.offer = false;
+    client->setCompression(uncompressed);
+#endif
+    client.connect();
+
+    // a socket that takes a few bytes at a time still gets whole frames,
+    // as long as the producer waits for writable()
+    client.loopback.limitWrites(7);
+    std::string payload = payloadOfSize(200);
+    size_t acked = 0;
+    unsigned long start = millis();
+    for (int i = 0; i < 4; i++) {
+        while (!client->writable() && millis() - start < 1000) {
+            client->loop();
+        }
+        client->emit("bench", payload.c_str(), [&](const char *data) {
+            acked += data && strlen(data) == 200;
+        });
+    }
+    while (acked < 4 && millis() - start < 1000) {
+        client->loop();
+    }
+    check(acked == 4, "acks through short writes");
+
+    // one that takes nothing fills the buffer, then frames are refused
+    client.loopback.limitWrites(0);
+    size_t sent = 0;
+    unsigned long dropped = client->droppedFrames();
+    while (sent < 100 && client->emit("bench", payload.c_str())) sent++;
+    check(sent > 0 && sent < 100 && !client->writable() && client->droppedFrames() == dropped + 1, "full transmit buffer");
+    bool drained = false;
+    client->onDrain([&]() { drained = true; });
+    client.loopback.limitWrites(SIZE_MAX);
+    start = millis();
+    while (!drained && millis() - start < 1000) {
+        client->loop();
+    }
+    check(drained && client->queuedBytes() == 0 && client->state() == sIOstate_CONNECTED, "drain after backpressure");
+
+    // a frame longer than the buffer is only begun on an empty one, a binary
+    // packet only queued with room for its attachment: both are refused at
+    // once while the socket takes nothing
+    client.loopback.limitWrites(0);
+    check(client->emit("bench", payload.c_str()), "frame queued on a stalled socket");
+    size_t queued = client->queuedBytes();
+    std::string oversized = payloadOfSize(TX_BUFFER_LEN + 100);
+    std::vector<uint8_t> attachment(300, 0xa5);
+    dropped = client->droppedFrames();
+    start = millis();
+    bool refused = !client->emit("bench", oversized.c_str()) &&
+        !client->emitBinary("bench", attachment.data(), attachment.size());
+    check(refused && millis() - start < 50 && client->droppedFrames() == dropped + 3 &&
+        client->queuedBytes() == queued, "frames refused on a stalled socket");
+
+    // once it takes data again they go out, the long ones in pieces, through short writes too
+    std::string echoed;
+    client->on("echo", [&](socketIOStreamPhase_t phase, const char *chunk, size_t length) {
+        if (phase == sIOstream_BEGIN) echoed.clear();
+        if (phase == sIOstream_DATA) echoed.append(chunk, length);
+    });
+    client.loopback.limitWrites(64);
+    acked = 0;
+    bool queuedAll = client->emit("echo", oversized.c_str()) &&
+        client->emitBinary("bench", attachment.data(), attachment.size(), [&](const socketIOView_t &,
+        const socketIOAttachments_t &attachments) { acked += attachments.count == 1; });
+    std::vector<uint8_t> longAttachment(TX_BUFFER_LEN + 100, 0x5a);
+    queuedAll &= client->emitBinary("bench", longAttachment.data(), longAttachment.size());
+    start = millis();
+    while ((!acked || echoed != oversized) && millis() - start < 1000) {
+        client->loop();
+    }
+    check(queuedAll && acked && echoed == oversized && client->state() == sIOstate_CONNECTED,
+        "frames longer than the transmit buffer");
+
+    // a socket that stalls in the middle of one fails the connection after the write timeout
+    socketIOTimeouts_t timeouts;
+    timeouts.write = 50;
+    client->setTimeouts(timeouts);
+    client->flush();
+    client.loopback.limitWrites(0);
+    start = millis();
+    check(!client->emit("bench", oversized.c_str()) && millis() - start >= 50 &&
+        client->state() != sIOstate_CONNECTED, "write stalled in a frame longer than the transmit buffer");
+    client->disconnect();
+}
+
+#if SOCKETIO_LATEST_SLOTS
+static void checkLatest() {
+    benchClient_t client;
+    std::string last;
+    size_t echoes = 0;
+    client->on("echo", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        last = std::string(data.ptr, data.length);
+        echoes++;
+    });
+    client.connect();
+
+    // a socket that takes nothing: samples replace each other instead of queueing
+    client.loopback.limitWrites(0);
+    char sample[16];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(sample, sizeof(sample), "%d", i);
+        check(client->emitLatest("echo", sample), "latest value slot");
+        client->loop();
+    }
+    check(client->queuedBytes() < TX_BUFFER_LEN && client->supersededEvents() > 900 &&
+        client->supersededEvents("echo") == client->supersededEvents(), "superseded samples");
+    client.loopback.limitWrites(SIZE_MAX);
+    unsigned long start = millis();
+    // the content is quoted unless it is JSON, as with emit()
+    while (last != "\"999\"" && millis() - start < 1000) client->loop();
+    check(last == "\"999\"", "the latest sample is sent");
+
+    // at most one sample per minInterval
+    echoes = 0;
+    start = millis();
+    while (millis() - start < 200) {
+        client->emitLatest("echo", "1", 50);
+        client->loop();
+    }
+    while (millis() - start < 300) client->loop();
+    check(echoes >= 4 && echoes <= 6, "latest value rate limit");
+
+    // a slot per key, until there are none left
+    size_t slots = 0;
+    char key[8];
+    for (int i = 0; i < SOCKETIO_LATEST_SLOTS + 1; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        slots += client->emitLatest("echo", "2", 0, key);
+    }
+    check(slots == SOCKETIO_LATEST_SLOTS - 1, "latest value slots are limited");
+    client->forgetLatest("k0");
+    check(client->emitLatest("echo", "3", 0, "other"), "forgotten slots are reused");
+    client->disconnect();
+}
+#endif
+
+static void checkNamespaces() {
+    benchClient_t client;
+    socketIOReconnectPolicy_t policy;
+    policy.initialDelay = 20;
+    policy.jitter = 0;
+    client->setReconnectPolicy(policy);
+    std::string root, telemetry;
+    int connects = 0, disconnects = 0, errors = 0;
+    client->on("echo", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        root += std::string(data.ptr, data.length) + ";";
+    });
+    SocketIONamespace *ns = client->of("/telemetry");
+    SocketIONamespace *denied = client->of("/private");
+    check(ns && denied && client->of("/telemetry") == ns && client->of("/") != ns, "of()");
+    ns->on("echo", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        telemetry += std::string(data.ptr, data.length) + ";";
+    });
+    ns->on("connect", [&](const socketIOView_t &, const socketIOAck_t &) { connects++; });
+    ns->on("disconnect", [&](const socketIOView_t &, const socketIOAck_t &) { disconnects++; });
+    denied->on("connect_error", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        errors += data.equals("{\"message\":\"Not authorized\"}");
+    });
+    auto wait = [&](std::function<bool ()> done) {
+        unsigned long start = millis();
+        while (!done() && millis() - start < 1000) client->loop();
+        return done();
+    };
+
+    client->connect("loopback", 0);
+    check(waitConnected(*client) && wait([&]() { return ns->connected() && errors == 1; }), "namespaces joined");
+    check(connects == 1 && !denied->connected() && !denied->emit("echo", "1"), "namespace connect error");
+    std::string ackPayload;
+    ns->emit("echo", "1");
+    ns->emitArgs("echo", 2, true);
+    ns->emitArgs(SOCKETIO_EVENT("echo"), "three");
+    ns->emit("ping", "4", [&](const char *payload) { ackPayload = payload ? payload : "(none)"; });
+    client->emit("echo", "5");
+    check(wait([&]() { return telemetry.size() >= 18 && !ackPayload.empty() && !root.empty(); }) &&
+        telemetry == "\"1\";2,true;\"three\";" && root == "\"5\";" && ackPayload == "4", "events kept to their namespace");
+
+    // the server drops the namespace, the connection stays
+    ns->emit("ping", "5", [&](const char *payload) { ackPayload = payload ? payload : "(none)"; });
+    ns->emit("kick", "1");
+    check(wait([&]() { return disconnects == 1; }) && !ns->connected() && client->connected(), "namespace disconnected by the server");
+    ns->join();
+    check(wait([&]() { return ns->connected(); }) && connects == 2, "namespace joined again");
+
+    // after a reconnect the namespaces are joined again, without asking
+    client.loopback.stop();
+    client->loop();
+    check(!ns->connected(), "namespace down with the connection");
+    check(wait([&]() { return ns->connected(); }) && connects == 3, "namespace joined after a reconnect");
+    ns->leave();
+    check(!ns->connected() && !ns->emit("echo", "1"), "namespace left");
+
+    check(client->of("/a") != NULL && client->of("/b") == NULL, "SOCKETIO_MAX_NAMESPACES namespaces");
+}
+
+static void checkReconnect() {
+    benchClient_t client;
+    socketIOReconnectPolicy_t policy;
+    policy.initialDelay = 20;
+    policy.jitter = 0;
+    client->setReconnectPolicy(policy);
+    std::string received;
+    client->on("echo", [&](const socketIOView_t &data, const socketIOAck_t &) {
+        received += std::string(data.ptr, data.length) + ";";
+    });
+    client.connect();
+
+    // events emitted while the connection is down come back in order once it is up again
+    client.loopback.stop();
+    client->loop();
+    unsigned long lost = millis();
+    check(client->state() == sIOstate_DISCONNECTED, "connection loss");
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+    client->emit("echo", "1");
+    client->emit("echo", "{\"n\":2}");
+    client->emit("echo", NULL);
+    client->emitArgs("echo", 4, "x");
+    check(client->bufferedEvents() == 4, "events held while offline");
+#endif
+    check(waitConnected(*client) && millis() - lost >= policy.initialDelay, "reconnect after the backoff delay");
+    check(client->reconnectAttempts() == 1, "reconnect attempts");
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+    unsigned long start = millis();
+    while (received.size() < 20 && millis() - start < 1000) {
+        client->loop();
+    }
+    check(received == "\"1\";{\"n\":2};;4,\"x\";" && client->bufferedEvents() == 0, "offline events replayed in order");
+
+    // a full buffer gives up the oldest events
+    client->disconnect();
+    std::string payload = payloadOfSize(100);
+    for (int i = 0; i < 10; i++) client->emit("echo", payload.c_str());
+    check(client->droppedEvents() > 0 && client->bufferedEvents() == 10 - client->droppedEvents(), "full offline buffer");
+#endif
+}
+
+#if SOCKETIO_CAPTURE_LEN
+static void checkCapture() {
+    // merged while within SOCKETIO_CAPTURE_MERGE_US, the oldest dropped once full
+    SocketIOCapture<64> ring;
+    ring.record(sIOcapture_CONNECT, 0, "h:1", 3);
+    ring.record(sIOcapture_OUT, 10, "GET", 3);
+    ring.record(sIOcapture_OUT, 20, " /", 2);
+    ring.record(sIOcapture_IN, 5000, "0123456789", 10);
+    check(ring.records() == 3 && ring.dropped() == 0, "capture merges writes");
+    ring.record(sIOcapture_IN_MESSAGE, 9000, "abcdefghijklmnopqrstuvwxyz0123456789", 36);
+    check(ring.records() == 2 && ring.dropped() == 2 && ring.length() <= 64, "capture drops the oldest records");
+    StringPrint dump;
+    ring.dump(dump);
+    std::vector<replayRecord_t> records;
+    unsigned long dropped = 0;
+    check(parseCapture(dump.text, records, dropped) && dropped == 2 && records.size() == 2 &&
+        records[1].type == sIOcapture_IN_MESSAGE && records[1].time == 4000 && records[1].data.size() == 36,
+        "capture dump parses");
+    uint8_t big[100] = {0};
+    ring.record(sIOcapture_IN, 9100, big, sizeof(big));
+    check(ring.records() == 0 && ring.dropped() == 5, "capture clears for a record it cannot hold");
+
+    // a capture whose beginning was dropped replays from a message on
+    benchClient_t client;
+    std::vector<std::string> live;
+    replayReport_t report;
+    SocketIOReplay::watch(*client, report, [&live](const socketIOPacketView_t &packet) {
+        live.push_back(packet.event.toString().c_str() + std::string(" ") + packet.data.toString().c_str());
+    });
+    client.connect();
+    std::string text(100, 'x');
+    for (int i = 0; i < 400; i++) {
+        client->emitArgs("echo", i, text.c_str());
+        client->loop();
+    }
+    SocketIOReplay::unwatch(*client);
+    StringPrint capture;
+    client->dumpCapture(capture, true);
+
+    SocketIOReplay replay;
+    std::vector<std::string> replayed;
+    replay.onEvent([&replayed](const socketIOPacketView_t &packet) {
+        replayed.push_back(packet.event.toString().c_str() + std::string(" ") + packet.data.toString().c_str());
+    });
+    check(replay.load(capture.text) && replay.dropped() > 0, "capture wraps");
+    std::unique_ptr<SocketIOClient> replayClient(new SocketIOClient());
+    report = replay.run(*replayClient);
+    check(report.synthetic && report.complete && !replayed.empty() && replayed.size() < live.size() &&
+        std::equal(replayed.begin(), replayed.end(), live.end() - replayed.size()), "capture replays its last messages");
+}
+#endif
+
+#ifdef SOCKETIO_STATS
+static void checkStats(FakeServer &server) {
+    benchClient_t client(&server);
+    size_t echoed = 0;
+    client->on("echo", [&](const socketIOView_t &, const socketIOAck_t &) { echoed++; });
+    client.connect();
+    client->resetStats();
+
+    for (int i = 0; i < 10; i++) client->emit("echo", "{\"n\":1}");
+    unsigned long start = millis();
+    while (echoed < 10 && millis() - start < 1000) {
+        client->loop();
+    }
+    socketIOStats_t stats = client->stats();
+    uint32_t parsed = 0;
+    for (uint32_t count : stats.parseTime) parsed += count;
+    check(stats.framesOut == 10 && stats.framesIn == 10 && stats.bytesIn > 0 && stats.bytesOut > 10 * 20 &&
+        stats.events == 10 && client->eventCount("echo") == 10 && parsed == 10, "stats counters");
+    char snapshot[256];
+    size_t length = client->snapshotStats(snapshot, sizeof(snapshot));
+    check(length < sizeof(snapshot) && strstr(snapshot, "\"events\":{\"echo\":10,\"\":0}"), "stats snapshot");
+    printf("%s\n", snapshot);
+    client->disconnect();
+}
+#endif
+
+// The benchmarks and checks of each feature, sizes that fit the default buffers
+static const size_t sizes[] = { 16, 64, 256, 480 };
+
+static void runParse(FakeServer &) {
+    for (size_t size : sizes) benchParse(size);
+}
+
+static void runCursor(FakeServer &) {
+    for (size_t size : sizes) benchCursor(size);
+    checkCursor();
+}
+
+static void runParser(FakeServer &) {
+    for (size_t size : sizes) benchParser(size);
+    checkControlFrames();
+    checkHandlers();
+}
+
+static void runStream(FakeServer &) {
+    for (size_t size : sizes) benchStream(size);
+    benchStream(4096);
+    benchStream(65536);
+}
+
+static void runEmit(FakeServer &) {
+    for (size_t size : sizes) benchEmit(size);
+}
+
+static void runTypedEmit(FakeServer &) {
+    // emitArgs() serializes behind the frames already queued, in what is left of TX_BUFFER_LEN
+    const size_t typedSizes[] = { 16, 64, 256, 400 };
+    for (size_t size : typedSizes) benchEmitTyped(size);
+    checkTypedEmit();
+}
+
+static void runAck(FakeServer &server) {
+    for (size_t size : sizes) benchAck(server, size);
+    checkAckReplies();
+    checkAckTable();
+}
+
+static void runBinary(FakeServer &server) {
+    // an acked attachment shares the receive buffer with its packet, base64 takes a third more
+    const size_t binarySizes[] = { 16, 64, 256, 320 };
+    for (size_t size : binarySizes) benchEmitBinary(size);
+    for (size_t size : binarySizes) benchBinaryAck(server, size, sIObinary_NATIVE);
+    for (size_t size : binarySizes) benchBinaryAck(server, size, sIObinary_BASE64);
+}
+
+static void runConnect(FakeServer &server) {
+    benchConnect(server, sIOconnect_POLLING);
+    benchConnect(server, sIOconnect_WEBSOCKET);
+    checkDirectWebSocket(server);
+    checkBegin(server);
+    checkDefaultNamespace(server);
+}
+
+static void runTask(FakeServer &server) {
+    checkRing();
+    for (size_t size : sizes) benchTask(server, size);
+    checkTaskBacklog(server);
+}
+
+static void runBackpressure(FakeServer &) {
+    checkBackpressure();
+}
+
+#ifdef SOCKETIO_DEFLATE
+static uint32_t crc32(const uint8_t *data, size_t length) {
+    uint32_t crc = 0xFFFFFFFFUL;
+    while (length--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) crc = crc >> 1 ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static void checkInflate(FakeServer &) {
+    // what zlib sends, not only what the stand-in server's fixed Huffman deflater does, inflated
+    // in place into a buffer as long as the message and the end of the input still unread
+    const size_t slack = 4;
+    std::unique_ptr<WebSocketInflater> inflater(new WebSocketInflater());
+    std::vector<uint8_t> buffer;
+    for (const deflateVector_t &vector : deflateVectors) {
+        buffer.assign(vector.data, vector.data + vector.length);
+        buffer.resize(std::max(vector.length, vector.inflated + slack));
+        inflater->reset();
+        size_t inflated = 0;
+        bool ok = inflater->inflate(buffer.data(), vector.length, buffer.size(), inflated);
+        check(ok && inflated == vector.inflated && crc32(buffer.data(), inflated) == vector.crc, vector.name);
+    }
+
+    // one byte short, a block type that does not exist, a message cut short
+    const deflateVector_t &dynamic = deflateVectors[0];
+    buffer.assign(dynamic.data, dynamic.data + dynamic.length);
+    buffer.resize(dynamic.inflated - 1);
+    size_t inflated;
+    inflater->reset();
+    check(!inflater->inflate(buffer.data(), dynamic.length, buffer.size(), inflated), "inflated message too long");
+    buffer.assign(dynamic.data, dynamic.data + dynamic.length);
+    buffer[0] |= 0x06;
+    buffer.resize(dynamic.inflated + slack);
+    inflater->reset();
+    check(!inflater->inflate(buffer.data(), dynamic.length, buffer.size(), inflated), "reserved block type");
+    buffer.assign(dynamic.data, dynamic.data + dynamic.length / 2);
+    buffer.resize(dynamic.inflated + slack);
+    inflater->reset();
+    check(!inflater->inflate(buffer.data(), dynamic.length / 2, buffer.size(), inflated), "truncated message");
+
+    measure("inflate", dynamic.inflated, iterations / 100, [&]() {
+        buffer.assign(dynamic.data, dynamic.data + dynamic.length);
+        buffer.resize(dynamic.inflated + slack);
+        inflater->inflate(buffer.data(), dynamic.length, buffer.size(), inflated);
+    });
+}
+#endif
+
+static void runReconnect(FakeServer &) {
+    checkReconnect();
+}
+
+static void runNamespaces(FakeServer &) {
+    checkNamespaces();
+}
+
+#if SOCKETIO_LATEST_SLOTS
+static void runLatest(FakeServer &) {
+    checkLatest();
+}
+#endif
+
+#if SOCKETIO_CAPTURE_LEN
+static void runCapture(FakeServer &) {
+    checkCapture();
+}
+#endif
+
+struct benchFeature_t {
+    const char *name;
+    void (*run)(FakeServer &server);  // NULL if not built in
+};
+
+// In the order they run, each one a ctest case of its own
+static const benchFeature_t features[] = {
+    { "parse", runParse },
+    { "cursor", runCursor },
+    { "parser", runParser },
+    { "stream", runStream },
+    { "emit", runEmit },
+    { "typed_emit", runTypedEmit },
+    { "ack", runAck },
+    { "binary", runBinary },
+    { "connect", runConnect },
+    { "heartbeat", checkHeartbeat },
+    { "transport", checkTransport },
+    { "task", runTask },
+    { "footprint", checkStaticFootprint },
+    { "backpressure", runBackpressure },
+    { "reconnect", runReconnect },
+    { "namespaces", runNamespaces },
+#if SOCKETIO_LATEST_SLOTS
+    { "latest", runLatest },
+#else
+    { "latest", NULL },
+#endif
+#if SOCKETIO_CAPTURE_LEN
+    { "capture", runCapture },
+#else
+    { "capture", NULL },
+#endif
+#ifdef SOCKETIO_STATS
+    { "stats", checkStats },
+#else
+    { "stats", NULL },
+#endif
+#ifdef SOCKETIO_DEFLATE
+    { "deflate", checkInflate },
+#else
+    { "deflate", NULL },
+#endif
+};
+
+// ctest's SKIP_RETURN_CODE, for features this build leaves out
+static const int SKIPPED = 77;
+
+int main(int argc, char **argv) {
+    std::vector<const benchFeature_t *> selected;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            iterations = 2000;
+            continue;
+        }
+        if (strcmp(argv[i], "--list") == 0) {
+            for (const benchFeature_t &feature : features) printf("%s\n", feature.name);
+            return 0;
+        }
+        const benchFeature_t *found = NULL;
+        for (const benchFeature_t &feature : features) {
+            if (strcmp(argv[i], feature.name) == 0) found = &feature;
+        }
+        if (found == NULL) {
+            fprintf(stderr, "unknown feature %s, see --list\n", argv[i]);
+            return 2;
+        }
+        selected.push_back(found);
+    }
+    if (selected.empty()) {
+        for (const benchFeature_t &feature : features) selected.push_back(&feature);
+    }
+
+    FakeServer server;
+    if (!server.start()) {
+        fprintf(stderr, "cannot start the loopback server\n");
+        return 1;
+    }
+
+    size_t ran = 0;
+    printf("%-10s %6s %12s %10s %10s\n", "benchmark", "bytes", "ops/s", "p50 ns", "p99 ns");
+    for (const benchFeature_t *feature : selected) {
+        if (feature->run == NULL) {
+            printf("%s: not in this build\n", feature->name);
+            continue;
+        }
+        currentFeature = feature->name;
+        feature->run(server);
+        ran++;
+    }
+
+    server.stop();
+    if (failed) return 1;
+    return ran ? 0 : SKIPPED;
+}
@@ -0,0 +1,48 @@
+/*
+Runs the stand-in server on its own, to point sketches or other clients at.
+Usage: fake_server [port]
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <FakeServer.h>
+#include <signal.h>
+
+static volatile sig_atomic_t running = 1;
+
+static void onSignal(int) {
+    running = 0;
+}
+
+int main(int argc, char **argv) {
+    uint16_t port = argc > 1 ? atoi(argv[1]) : 3484;
+    FakeServer server;
+    if (!server.start(port)) {
+        fprintf(stderr, "cannot listen on port %u\n", port);
+        return 1;
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    printf("listening on 127.0.0.1:%u\n", server.port());
+    while (running) {
+        delay(100);
+    }
+    server.stop();
+    printf("%lu events received\n", FakeSession::eventsReceived.load());
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+Runs a fleet of simulated devices against a Socket.IO server and reports
+handshake and ack latencies, throughput and errors.
+Usage: socketio_fleet [--host h --port p] [--clients n] [--loops n] [--duration s]
+                      [--ramp ms] [--b64] [--websocket] [--eio4] [--emit interval:event:size[:ack][:binary]]...
+Without --host the fleet runs against the stand-in server, in the same process.
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <FakeServer.h>
+#include <Fleet.h>
+#include <string.h>
+
+static bool parseEmit(const char *spec, fleetEmit_t &line) {
+    std::string text(spec);
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (;;) {
+        size_t colon = text.find(':', start);
+        fields.push_back(text.substr(start, colon - start));
+        if (colon == std::string::npos) break;
+        start = colon + 1;
+    }
+    if (fields.size() < 3) return false;
+    line.interval = strtoul(fields[0].c_str(), NULL, 10);
+    line.event = fields[1];
+    line.size = strtoul(fields[2].c_str(), NULL, 10);
+    for (size_t i = 3; i < fields.size(); i++) {
+        if (fields[i] == "ack") line.ack = true;
+        else if (fields[i] == "binary") line.binary = true;
+        else return false;
+    }
+    return line.interval > 0 && !line.event.empty();
+}
+
+int main(int argc, char **argv) {
+    fleetOptions_t options;
+    bool remote = false;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--b64") == 0) {
+            options.binaryMode = sIObinary_BASE64;
+            continue;
+        }
+        if (strcmp(arg, "--websocket") == 0) {
+            options.connectMode = sIOconnect_WEBSOCKET;
+            continue;
+        }
+        if (strcmp(arg, "--eio4") == 0) {
+            options.protocol = sIOprotocol_EIO4;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "%s: missing value\n", arg);
+            return 2;
+        }
+        i++;
+        if (strcmp(arg, "--host") == 0) {
+            options.host = value;
+            remote = true;
+        } else if (strcmp(arg, "--port") == 0) {
+            options.port = atoi(value);
+        } else if (strcmp(arg, "--clients") == 0) {
+            options.clients = strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--loops") == 0) {
+            options.loops = strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--duration") == 0) {
+            options.duration = strtoul(value, NULL, 10) * 1000;
+        } else if (strcmp(arg, "--ramp") == 0) {
+            options.ramp = strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--emit") == 0) {
+            fleetEmit_t line;
+            if (!parseEmit(value, line)) {
+                fprintf(stderr, "--emit %s: expected interval:event:size[:ack][:binary]\n", value);
+                return 2;
+            }
+            options.script.push_back(line);
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 2;
+        }
+    }
+    if (options.script.empty()) {
+        fleetEmit_t line;
+        line.ack = true;
+        options.script.push_back(line);
+    }
+
+    FakeServer server;
+    if (!remote) {
+        if (!server.start()) {
+            fprintf(stderr, "cannot start the loopback server\n");
+            return 1;
+        }
+        options.port = server.port();
+    }
+    printf("%zu clients on %zu loops against %s:%u, %lu ms ramp, %lu ms run\n", options.clients,
+        options.loops, options.host, options.port, options.ramp, options.duration);
+
+    fleetReport_t report = Fleet(options).run();
+    report.print(stdout);
+    server.stop();
+    return report.ok() ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/*
+Replays a capture written by dumpCapture() through the client's decoder and
+dispatcher and reports the events it dispatched, their digest and the
+throughput. With --record it first records one against the stand-in server,
+in this process, and checks that replaying it gives what the live client got.
+Usage: socketio_replay [--realtime] [--print] [--repeat n] capture
+       socketio_replay --record capture [--events n] [--websocket] [--eio4] [--hex]
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <Replay.h>
+#include <string.h>
+
+static bool readFile(const char *path, std::string &bytes) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.append(buffer, n);
+    }
+    fclose(file);
+    return true;
+}
+
+static void printEvent(const socketIOPacketView_t &packet) {
+    printf("%.*s %.*s\n", (int)packet.event.length, packet.event.ptr, (int)packet.data.length, packet.data.ptr);
+}
+
+/**
+ * Echo events of growing sizes, some of them acked, against the stand-in
+ * server, until they are sent or the capture would drop its beginning.
+ */
+static int record(const char *path, unsigned long events, socketIOConnectMode_t mode, socketIOProtocol_t protocol, bool hex) {
+    FakeServer server;
+    if (!server.start()) {
+        fprintf(stderr, "cannot start the loopback server\n");
+        return 1;
+    }
+    std::unique_ptr<SocketIOClient> client(new SocketIOClient());
+    client->setConnectMode(mode);
+    client->setProtocol(protocol);
+    replayReport_t live;
+    SocketIOReplay::watch(*client, live);
+    client->connect("127.0.0.1", server.port());
+    unsigned long start = millis();
+    while (!client->connected() && millis() - start < 5000) {
+        client->loop();
+    }
+    if (!client->connected()) {
+        fprintf(stderr, "cannot connect to the loopback server\n");
+        return 1;
+    }
+    unsigned long sent = 0;
+    unsigned long acked = 0;
+    std::string text;
+    while (sent < events && client->capturedBytes() < SOCKETIO_CAPTURE_LEN * 3 / 4 && millis() - start < 10000) {
+        if (live.events > sent) {
+            text.assign(sent % 200, 'x');
+            client->emitArgs("echo", sent, text.c_str(), sent % 3 == 0);
+            if (sent % 4 == 0) {
+                client->emit("telemetry", "{\"n\":1}", [&acked](const char *) { acked++; });
+            }
+            sent++;
+        }
+        client->loop();
+    }
+    // the last echo
+    start = millis();
+    while (live.events <= sent && millis() - start < 1000) {
+        client->loop();
+    }
+    SocketIOReplay::unwatch(*client);
+    client->disconnect();
+    server.stop();
+
+    StringPrint capture;
+    client->dumpCapture(capture, hex);
+    FILE *file = fopen(path, "wb");
+    if (file == NULL || fwrite(capture.text.data(), 1, capture.text.size(), file) != capture.text.size()) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    fclose(file);
+    printf("recorded    %lu events, %lu acks, %zu bytes\n", live.events, acked, capture.text.size());
+
+    SocketIOReplay replay;
+    if (!replay.load(capture.text)) {
+        fprintf(stderr, "the capture does not parse\n");
+        return 1;
+    }
+    std::unique_ptr<SocketIOClient> replayed(new SocketIOClient());
+    replayReport_t report = replay.run(*replayed);
+    report.print(stdout);
+    if (!report.complete || report.events != live.events || report.digest != live.digest) {
+        fprintf(stderr, "the replay dispatched %lu events, digest %08x, the live client %lu, digest %08x\n",
+            report.events, (unsigned int)report.digest, live.events, (unsigned int)live.digest);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *recordPath = NULL;
+    bool realTime = false;
+    bool print = false;
+    bool hex = false;
+    unsigned long repeat = 1;
+    unsigned long events = 1000;
+    socketIOConnectMode_t mode = sIOconnect_POLLING;
+    socketIOProtocol_t protocol = sIOprotocol_EIO3;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--realtime") == 0) {
+            realTime = true;
+        } else if (strcmp(arg, "--print") == 0) {
+            print = true;
+        } else if (strcmp(arg, "--hex") == 0) {
+            hex = true;
+        } else if (strcmp(arg, "--websocket") == 0) {
+            mode = sIOconnect_WEBSOCKET;
+        } else if (strcmp(arg, "--eio4") == 0) {
+            protocol = sIOprotocol_EIO4;
+        } else if (arg[0] != '-') {
+            path = arg;
+        } else if (!value) {
+            fprintf(stderr, "%s: missing value\n", arg);
+            return 2;
+        } else if (strcmp(arg, "--repeat") == 0) {
+            repeat = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--events") == 0) {
+            events = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--record") == 0) {
+            recordPath = argv[++i];
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 2;
+        }
+    }
+    if (recordPath) return record(recordPath, events, mode, protocol, hex);
+    if (path == NULL) {
+        fprintf(stderr, "usage: socketio_replay [--realtime] [--print] [--repeat n] capture\n");
+        return 2;
+    }
+
+    std::string capture;
+    SocketIOReplay replay;
+    if (!readFile(path, capture) || !replay.load(capture)) {
+        fprintf(stderr, "%s: no capture\n", path);
+        return 1;
+    }
+    if (print) {
+        replay.onEvent(printEvent);
+    }
+    bool ok = true;
+    uint32_t digest = 0;
+    for (unsigned long i = 0; i < repeat; i++) {
+        std::unique_ptr<SocketIOClient> client(new SocketIOClient());
+        replayReport_t report = replay.run(*client, realTime);
+        if (i == 0 || i + 1 == repeat) report.print(stdout);
+        // every run has to dispatch the same
+        ok &= report.complete && (i == 0 || report.digest == digest);
+        digest = report.digest;
+        replay.onEvent(nullptr);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _SOCKET_IO_CAPTURE_H
+#define _SOCKET_IO_CAPTURE_H
+
+#include <Arduino.h>
+#include <string.h>
+
+// Reads and writes this many us after the start of a record are appended to it
+#ifndef SOCKETIO_CAPTURE_MERGE_US
+#define SOCKETIO_CAPTURE_MERGE_US 1000
+#endif
+
+#define SOCKETIO_CAPTURE_VERSION 1
+
+typedef enum : uint8_t {
+    sIOcapture_CONNECT = 'C',    ///< The transport connected, to "host:port"
+    sIOcapture_WEBSOCKET = 'W',  ///< The upgrade was accepted, one byte of flags: 1 permessage-deflate
+    sIOcapture_IN = 'i',         ///< Bytes read
+    sIOcapture_IN_MESSAGE = 'I', ///< Bytes read from the start of a WebSocket message on, a replay may begin there
+    sIOcapture_OUT = 'o',        ///< Bytes written
+    sIOcapture_CLOSE = 'X',      ///< The connection failed or was closed
+} socketIOCaptureType_t;
+
+/**
+ * Ring of the bytes a connection read and wrote, for replaying them later.
+ * Each record is its type, the us since the record before it as a base 128
+ * varint, its 16 bit little endian length and its bytes. When the N bytes,
+ * a power of two, are full the oldest records are dropped. dump() writes
+ * "SIOC", the format version and the number of dropped records as a varint,
+ * then the records, oldest first.
+ */
+template <size_t N>
+class SocketIOCapture {
+    static_assert(N >= 64 && (N & (N - 1)) == 0, "the capture length has to be a power of two");
+public:
+    void record(socketIOCaptureType_t type, unsigned long now, const void *data, size_t length) {
+        while (length > 0xFFFF) {
+            record(type, now, data, 0xFFFF);
+            data = (const uint8_t *)data + 0xFFFF;
+            length -= 0xFFFF;
+        }
+        // times shared by several reads may lag behind a write recorded in between
+        unsigned long delta = _records && (long)(now - _lastTime) > 0 ? now - _lastTime : 0;
+        // reads and writes come in small pieces, the frame header apart from its payload
+        bool merge = _records && length && _lastLength + length <= 0xFFFF && delta < SOCKETIO_CAPTURE_MERGE_US &&
+            (type == sIOcapture_OUT ? _lastType == sIOcapture_OUT :
+             type == sIOcapture_IN && (_lastType == sIOcapture_IN || _lastType == sIOcapture_IN_MESSAGE));
+        if (merge && makeRoom(length, true)) {
+            put(_tail, data, length);
+            _tail += length;
+            _lastLength += length;
+            const uint8_t size[2] = { (uint8_t)_lastLength, (uint8_t)(_lastLength >> 8) };
+            put(_lastStart + _lastHeader - 2, size, 2);
+            return;
+        }
+
+        uint8_t header[16];
+        size_t n = 0;
+        header[n++] = type;
+        unsigned long time = _records ? _lastTime + delta : now;
+        do {
+            header[n] = delta & 0x7F;
+            delta >>= 7;
+            header[n++] |= delta ? 0x80 : 0;
+        } while (delta);
+        header[n++] = (uint8_t)length;
+        header[n++] = (uint8_t)(length >> 8);
+        if (n + length > N) {
+            // never fits, and what came before it is of no use without it
+            _dropped += _records + 1;
+            clear();
+            return;
+        }
+        makeRoom(n + length, false);
+        _lastStart = _tail;
+        _lastHeader = n;
+        _lastLength = length;
+        _lastType = type;
+        _lastTime = time;
+        put(_tail, header, n);
+        put(_tail + n, data, length);
+        _tail += n + length;
+        _records++;
+    }
+
+    /// Writes the capture, as it is or in hex lines for a serial monitor, @return the bytes written
+    size_t dump(Print &out, bool hex = false) const {
+        uint8_t header[16] = { 'S', 'I', 'O', 'C', SOCKETIO_CAPTURE_VERSION };
+        size_t n = 5;
+        unsigned long dropped = _dropped;
+        do {
+            header[n] = dropped & 0x7F;
+            dropped >>= 7;
+            header[n++] |= dropped ? 0x80 : 0;
+        } while (dropped);
+        size_t written = write(out, header, n, hex);
+        size_t offset = _head & (N - 1);
+        size_t length = _tail - _head;
+        size_t first = length < N - offset ? length : N - offset;
+        written += write(out, &_buffer[offset], first, hex);
+        written += write(out, _buffer, length - first, hex);
+        if (hex) written += out.write('\n');
+        return written;
+    }
+
+    void clear() {
+        _head = _tail;
+        _records = 0;
+    }
+
+    size_t length() const { return _tail - _head; }
+    size_t records() const { return _records; }
+    unsigned long dropped() const { return _dropped; }
+
+private:
+    /**
+     * Drops the oldest records until length bytes fit.
+     * @param keepLast fails instead of dropping the newest record
+     */
+    bool makeRoom(size_t length, bool keepLast) {
+        while (N - (_tail - _head) < length) {
+            if (keepLast && _head == _lastStart) return false;
+            size_t position = _head + 1;
+            while (_buffer[position++ & (N - 1)] & 0x80) {}
+            size_t size = _buffer[position & (N - 1)] | _buffer[(position + 1) & (N - 1)] << 8;
+            _head = position + 2 + size;
+            _records--;
+            _dropped++;
+        }
+        return true;
+    }
+
+    void put(size_t position, const void *data, size_t length) {
+        if (length == 0) return;
+        size_t offset = position & (N - 1);
+        size_t n = length < N - offset ? length : N - offset;
+        memcpy(&_buffer[offset], data, n);
+        memcpy(_buffer, (const uint8_t *)data + n, length - n);
+    }
+
+    static size_t write(Print &out, const uint8_t *data, size_t length, bool hex) {
+        if (!hex) return length ? out.write(data, length) : 0;
+        static const char digits[] = "0123456789abcdef";
+        size_t written = 0;
+        char line[65];
+        while (length) {
+            size_t n = length < 32 ? length : 32;
+            for (size_t i = 0; i < n; i++) {
+                line[2 * i] = digits[data[i] >> 4];
+                line[2 * i + 1] = digits[data[i] & 0x0F];
+            }
+            line[2 * n] = '\n';
+            written += out.write((const uint8_t *)line, 2 * n + 1);
+            data += n;
+            length -= n;
+        }
+        return written;
+    }
+
+    uint8_t _buffer[N];
+    // positions count up forever
+    size_t _head = 0;
+    size_t _tail = 0;
+    size_t _records = 0;
+    unsigned long _dropped = 0;
+    // the newest record, which reads and writes may be appended to
+    size_t _lastStart = 0;
+    size_t _lastHeader = 0;
+    size_t _lastLength = 0;
+    uint8_t _lastType = 0;
+    unsigned long _lastTime = 0;
+};
+
+#endif
@@ -23,29 +23,113 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 OTHER DEALINGS IN THE SOFTWARE.
 */
 #include <SocketIOClient.h>
+#include <algorithm>
+#include <new>
+#include <stdarg.h>
 
-void SocketIOClient::begin(const char* host, unsigned int port, const char* root_ca) {
+static size_t base64Encode(const uint8_t *data, size_t length, char *out);
+static bool base64Decode(const uint8_t *data, size_t length, uint8_t *out, size_t &outLength);
+static bool parseHead(const char *payload, size_t length, socketIOPacketView_t &packet, size_t &data);
+
+SocketIOClientBase::SocketIOClientBase(char *rxBuffer, size_t rxLength, uint8_t *txBuffer, size_t txLength,
+        handler_t *handlers, size_t maxHandlers, ack_t *acks, size_t maxAcks) :
+    databuffer(rxBuffer), _rxLength(rxLength), _decoder((uint8_t *)rxBuffer, rxLength),
+    _txBuffer(txBuffer), _txLength(txLength), _writer(txBuffer, txLength),
+    _handlers(handlers), _maxHandlers(maxHandlers), _acks(acks), _maxAcks(maxAcks) {
+    _namespaces[0]._client = this;
+    _namespaces[0]._name = "/";
+    _namespaces[0]._joined = true;
+}
+
+void SocketIOClientBase::begin(const char* host, unsigned int port, const char* root_ca) {
+    begin(host, port, root_ca ? sIOtransport_TLS : sIOtransport_PLAIN, root_ca);
+}
+
+void SocketIOClientBase::begin(const char* host, unsigned int port, socketIOTransport_t transport, const char* root_ca) {
     _host = host;
     _port = port;
+    _transport = transport;
     _root_ca = root_ca;
+#if defined(ESP8266)
+    _trustAnchorsStale = true;
+#endif
+    // arm the first attempt, loop() connects
+    _reconnecting = true;
+    _reconnectDelay = 0;
+    _retries = 0;
+    _directRefused = false;
+    _reuseRefused = false;
+}
+
+void SocketIOClientBase::setClient(Client &transport) {
+    client->stop();
+    client = &transport;
+    _customClient = true;
+    setState(sIOstate_DISCONNECTED);
+}
+
+bool SocketIOClientBase::connect(const char* host, unsigned int port, const char* root_ca) {
+    return connect(host, port, root_ca ? sIOtransport_TLS : sIOtransport_PLAIN, root_ca);
+}
+
+bool SocketIOClientBase::connect(const char* host, unsigned int port, socketIOTransport_t transport, const char* root_ca) {
+    begin(host, port, transport, root_ca);
+    if (_state == sIOstate_DISCONNECTED) {
+        connectStep();
+    }
+    return _state != sIOstate_DISCONNECTED;
+}
+
+
+bool SocketIOClientBase::connected() {
+    return _state == sIOstate_CONNECTED && client->connected();
+}
+
+void SocketIOClientBase::disconnect() {
+    _reconnecting = false;
+    if (_streamEvent) {
+        stream(sIOstream_ABORT);
+    }
+    discardTx();
+    client->stop();
+    capture(sIOcapture_CLOSE);
+    setState(sIOstate_DISCONNECTED);
+    expireAcks(true);
+}
+
+void SocketIOClientBase::setTimeouts(const socketIOTimeouts_t &timeouts) {
+    _timeouts = timeouts;
+}
+
+void SocketIOClientBase::setAckPolicy(const socketIOAckPolicy_t &policy) {
+    _ackPolicy = policy;
+}
+
+void SocketIOClientBase::setReconnectPolicy(const socketIOReconnectPolicy_t &policy) {
+    _reconnectPolicy = policy;
 }
 
-bool SocketIOClient::connect(const char* host, unsigned int port, const char* root_ca) {
-    begin(host, port, root_ca);
-    return clientConnected();
+void SocketIOClientBase::onStateChange(stateCallback_fn func) {
+    _stateCallback = func;
 }
 
+void SocketIOClientBase::setBinaryMode(socketIOBinaryMode_t mode) {
+    _binaryMode = mode;
+}
 
-bool SocketIOClient::connected() {
-    return client.connected();
+void SocketIOClientBase::setConnectMode(socketIOConnectMode_t mode) {
+    _connectMode = mode;
+    _directRefused = false;
 }
 
-void SocketIOClient::disconnect() {
-    client.stop();
+#ifdef SOCKETIO_DEFLATE
+void SocketIOClientBase::setCompression(const socketIOCompression_t &compression) {
+    _compression = compression;
 }
+#endif
 
 // find the nth colon starting from dataptr
-void SocketIOClient::findColon(char which) {
+void SocketIOClientBase::findColon(char which) {
     while (*dataptr) {
         if (*dataptr == ':') {
             if (--which <= 0) return;
@@ -55,427 +139,2186 @@ void SocketIOClient::findColon(char which) {
 }
 
 // terminate command at dataptr at closing double quote
-void SocketIOClient::terminateCommand(void) {
+void SocketIOClientBase::terminateCommand(void) {
     dataptr[strlen(dataptr) - 3] = 0;
 }
 
-void SocketIOClient::parser(int index) {
-    String payload = "";
-    int sizemsg = databuffer[index + 1];  // 0-125 byte, index ok        Fix provide by Galilei11. Thanks
-    if (databuffer[index + 1] > 125) {
-        sizemsg = databuffer[index + 2];  // 126-255 byte
-        index += 1;                       // index correction to start
+void SocketIOClientBase::parser(const char *payload, size_t length) {
+    if (length < 1) {
+        return;
     }
-    for (int i = index + 2; i < index + sizemsg + 2; i++)
-        payload += (char)databuffer[i];
-
-	size_t length = payload.length();
 	engineIOmessageType_t eType = (engineIOmessageType_t) payload[0];
     switch (eType) {
+        case eIOtype_OPEN:
+            if (_state != sIOstate_OPENING) break;
+            if (!parseOpenPacket(payload)) {
+                fail("open packet");
+                break;
+            }
+            DEBUG_WEBSOCKETS("Session %s opened", _sid);
+            sessionOpened();
+            break;
+
         case eIOtype_PING:
             DEBUG_WEBSOCKETS("Ping received - Sending Pong");
             sendPong();
             break;
 
         case eIOtype_PONG:
+            if (_state == sIOstate_PROBING && length == 6 && strncmp(payload, "3probe", 6) == 0) {
+                DEBUG_WEBSOCKETS("Probe answered - Upgrading");
+                sendCode("5");
+                sessionOpened();
+                break;
+            }
             DEBUG_WEBSOCKETS("Pong received - All good");
+#ifdef SOCKETIO_STATS
+            if (_pingPending) {
+                unsigned long rtt = micros() - _pingSent;
+                _pingPending = false;
+                if (_stats.rttAverage == 0) {
+                    _stats.rttMin = _stats.rttMax = _stats.rttAverage = rtt;
+                }
+                _stats.rttLast = rtt;
+                _stats.rttMin = std::min(_stats.rttMin, rtt);
+                _stats.rttMax = std::max(_stats.rttMax, rtt);
+                _stats.rttAverage += ((long)rtt - (long)_stats.rttAverage) / 8;
+            }
+#endif
             break;
 
-        case eIOtype_MESSAGE:
+        case eIOtype_MESSAGE: {
 			if(length < 2) {
 				break;
 			}
 			socketIOmessageType_t ioType = (socketIOmessageType_t) payload[1];
-			uint8_t * data = (uint8_t *)&payload[2];
+			const char * data = &payload[2];
 			size_t lData = length - 2;
-			socketIOPacket_t packet;
+			socketIOPacketView_t packet;
 			switch(ioType) {
 				case sIOtype_EVENT:
 					DEBUG_WEBSOCKETS("get event (%d): %s", lData, data);
-					packet = parse(std::string((char *)data));
+					if (!parsePacket(ioType, data, lData, packet)) {
+						DEBUG_WEBSOCKETS("Malformed event dropped");
+						break;
+					}
 					triggerEvent(packet);
 					break;
 				case sIOtype_CONNECT:
-					DEBUG_WEBSOCKETS("connected");
-					packet.event = "connect";
-					triggerEvent(packet);
-					break;
 				case sIOtype_DISCONNECT:
-					DEBUG_WEBSOCKETS("disconnected");
-					packet.event = "disconnect";
+				case sIOtype_ERROR: {
+					// [/namespace,][data]
+					if (lData && data[0] == '/') {
+						packet.nsp.ptr = data;
+						while (packet.nsp.length < lData && data[packet.nsp.length] != ',') packet.nsp.length++;
+						size_t skip = std::min(packet.nsp.length + 1, lData);
+						data += skip;
+						lData -= skip;
+					}
+					int nsp = findNamespace(packet.nsp);
+					if (nsp < 0) {
+						DEBUG_WEBSOCKETS("Packet %c for namespace %.*s not joined", ioType, (int)packet.nsp.length, packet.nsp.ptr);
+						break;
+					}
+					if (ioType == sIOtype_ERROR) {
+						DEBUG_WEBSOCKETS("error (%d): %s", lData, data);
+						packet.event = "connect_error";
+						packet.data = socketIOView_t(data, lData);
+						triggerEvent(packet);
+						break;
+					}
+					DEBUG_WEBSOCKETS(ioType == sIOtype_CONNECT ? "connected %s" : "disconnected %s", _namespaces[nsp]._name);
+					namespaceConnected(nsp, ioType == sIOtype_CONNECT);
+					packet.event = ioType == sIOtype_CONNECT ? "connect" : "disconnect";
 					triggerEvent(packet);
 					break;
+				}
 				case sIOtype_ACK:
 					DEBUG_WEBSOCKETS("get ack (%d): %s", lData, data);
-					packet = parse(std::string((char *)data));
+					if (!parsePacket(ioType, data, lData, packet)) {
+						DEBUG_WEBSOCKETS("Malformed ack dropped");
+						break;
+					}
 					triggerAck(packet);
 					break;
-				case sIOtype_ERROR:
 				case sIOtype_BINARY_EVENT:
 				case sIOtype_BINARY_ACK:
+					DEBUG_WEBSOCKETS("get binary %c (%d): %s", ioType, lData, data);
+					if (!parsePacket(ioType, data, lData, packet)) {
+						DEBUG_WEBSOCKETS("Malformed binary packet dropped");
+						break;
+					}
+					beginAttachments(ioType, packet);
+					break;
 				default:
 					DEBUG_WEBSOCKETS("Socket.IO Message Type %c (%02X) is not implemented", ioType, ioType);
 					DEBUG_WEBSOCKETS("get text: %s", payload);
 					break;
 			}
+			break;
+        }
+
+        default:
+            break;
     }
 }
 
-bool SocketIOClient::clientConnected(void) {
-    if (!connected()) {
-        if (_root_ca != NULL) {
-            client.setCACert(_root_ca);
+void SocketIOClientBase::setState(socketIOState_t state) {
+    if (_state == state) return;
+    _state = state;
+    _stateSince = millis();
+    if (state == sIOstate_CONNECTED) {
+        _retries = 0;
+        _handshakeTime = micros() - _handshakeStart;
+        SOCKETIO_STAT(_stats.handshakeTime = _handshakeTime / 1000;)
+    }
+    if (state == sIOstate_CONNECTING) {
+        _handshakeStart = micros();
+        SOCKETIO_STAT(_stats.connectTime = 0;)
+    }
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+    if (state != sIOstate_CONNECTED) {
+        _replay = false;
+    }
+#endif
+    if (state != sIOstate_CONNECTED) {
+        for (size_t i = 0; i < _namespaceCount; i++) {
+            _namespaces[i]._connected = false;
         }
-        if (!client.connect(_host, _port)) return false;
-        if(!doHandshake()) return false;
-        lastPing = millis();
     }
-    return true;
+    DEBUG_WEBSOCKETS("state %d", state);
+    if (_stateCallback) {
+        _stateCallback(state);
+    }
 }
 
-void SocketIOClient::loop() {
-    int index = -1;
-    int index2 = -1;
-    String tmp = "";
-    *databuffer = 0;
+// The WebSocket carries the session from here on
+void SocketIOClientBase::sessionOpened() {
+    lastPing = _lastReceived = millis();
+    setState(sIOstate_CONNECTED);
+    if (_eio4) {
+        // Socket.IO 3 and on do not join the default namespace by themselves
+        sendCode("40");
+    } else if (_pollingConnect) {
+        _pollingConnect = false;
+        parser("40", 2);
+    }
+}
 
-    if (!clientConnected()) return;
-    
-    if (millis() - lastPing >= pingInterval) {
-        sendPing();
-        lastPing = millis();
+void SocketIOClientBase::fail(const char *reason) {
+    DEBUG_WEBSOCKETS("connection failed: %s", reason);
+    (void)reason;
+    if (_streamEvent) {
+        stream(sIOstream_ABORT);
     }
+    discardTx();
+    client->stop();
+    capture(sIOcapture_CLOSE);
+    setState(sIOstate_DISCONNECTED);
+    expireAcks(true);
+    scheduleReconnect();
+}
+
+void SocketIOClientBase::scheduleReconnect() {
+    if (!_reconnectPolicy.enabled ||
+        (_reconnectPolicy.maxAttempts && _retries >= _reconnectPolicy.maxAttempts)) {
+        DEBUG_WEBSOCKETS("not reconnecting");
+        _reconnecting = false;
+        return;
+    }
+    unsigned long delay = _reconnectPolicy.initialDelay;
+    for (unsigned int i = 0; i < _retries && delay < _reconnectPolicy.maxDelay; i++) {
+        delay *= _reconnectPolicy.factor;
+    }
+    if (delay > _reconnectPolicy.maxDelay) {
+        delay = _reconnectPolicy.maxDelay;
+    }
+    unsigned long spread = delay / 100 * _reconnectPolicy.jitter + delay % 100 * _reconnectPolicy.jitter / 100;
+    delay -= random(std::min(spread, delay) + 1);
+    _retries++;
+    _reconnectFrom = millis();
+    _reconnectDelay = delay;
+    DEBUG_WEBSOCKETS("reconnecting in %lu ms", delay);
+}
+
+bool SocketIOClientBase::timedOut(unsigned long timeout) {
+    return millis() - _stateSince >= timeout;
+}
+
+/// The packets of an EIO 3 polling body, <length>:<packet>..., include the 40 of the default namespace
+static bool pollingBodyConnects(const char *body) {
+    while (*body) {
+        char *end;
+        unsigned long length = strtoul(body, &end, 10);
+        if (end == body || *end != ':') return false;
+        body = end + 1;
+        if (strnlen(body, length) < length) return false;
+        if (length == 2 && body[0] == '4' && body[1] == '0') return true;
+        body += length;
+    }
+    return false;
+}
+
+// Advances the handshake by at most one step, never waits for the server
+void SocketIOClientBase::connectStep() {
+    switch (_state) {
+        case sIOstate_DISCONNECTED: {
+            if (_host == NULL || !_reconnecting || millis() - _reconnectFrom < _reconnectDelay) return;
+            if (_retries) {
+                _reconnectAttempts++;
+                SOCKETIO_STAT(_stats.reconnects++;)
+            }
+            // masking keys only need to be unpredictable, seed once per connection
+            randomSeed(analogRead(0));
+            discardTx();
+            _binaryBase64 = _binaryMode == sIObinary_BASE64;
+            _eio4 = _protocol == sIOprotocol_EIO4;
+            _writer.seed(random(1, 0x7FFFFFFF) ^ micros());
+            _sid[0] = 0;
+            _pollingConnect = false;
+            if (!selectTransport()) {
+                DEBUG_WEBSOCKETS("no TLS on this interface, not connecting");
+                _reconnecting = false;
+                return;
+            }
+            setState(sIOstate_CONNECTING);
+            if (connectMode() == sIOconnect_WEBSOCKET) {
+                requestUpgrade(true);
+            } else {
+                requestPolling();
+            }
+            return;
+        }
 
-    if (!client.available()) return;
+        case sIOstate_POLLING: {
+            if (!readHttpResponse()) {
+                if (!client->connected()) fail("connection lost");
+                else if (timedOut(_timeouts.polling)) fail("polling timeout");
+                return;
+            }
+            // check for happy "HTTP/1.1 200" response
+            if (_httpStatus != 200) {
+                fail("polling status");
+                return;
+            }
+            if (!parseOpenPacket(databuffer)) {
+                fail("open packet");
+                return;
+            }
+            // Socket.IO 2 joins the default namespace in the same body, its
+            // 40 is handled once the WebSocket is up to send the joins over
+            _pollingConnect = !_eio4 && pollingBodyConnects(databuffer);
+            {
+                // the upgrade follows on the same connection if the server keeps it
+                // open, a TCP and a TLS handshake less
+                bool reuse = !_httpClose && _contentLength >= 0 && !_reuseRefused && client->connected();
+                if (!reuse) {
+                    client->stop();
+                }
+                requestUpgrade(!reuse);
+            }
+            return;
+        }
 
-    while (client.available()) {
-        readLine();
-        tmp = databuffer;
-        // Serial.println(databuffer);
-        dataptr = databuffer;
-        index = tmp.indexOf((char)129);  //129 DEC = 0x81 HEX = sent for proper communication
-        index2 = tmp.indexOf((char)129, index + 1);
-        if (index != -1) {
-            parser(index);
+        case sIOstate_UPGRADING: {
+            bool complete = readHttpResponse();
+            if (!complete && !client->connected()) {
+                if (_upgradeReused && _httpStatus == 0) {
+                    upgradeOnNewConnection();
+                    return;
+                }
+                fail("connection lost");
+                return;
+            }
+            if (!complete && !timedOut(_timeouts.upgrade)) return;
+            // check for "HTTP/1.1 101 response, means Updrage to Websocket OK
+            if (!complete || _httpStatus != 101) {
+                if (_sid[0] == 0) {
+                    // no WebSocket without a session here, try the polling handshake right away
+                    DEBUG_WEBSOCKETS("direct WebSocket refused, falling back to polling");
+                    _directRefused = true;
+                    client->stop();
+                    requestPolling();
+                    return;
+                }
+                fail(complete ? "upgrade status" : "upgrade timeout");
+                return;
+            }
+#ifdef SOCKETIO_DEFLATE
+            if (_deflateRejected) {
+                fail("extension negotiation");
+                return;
+            }
+            _inflater.reset();
+            _decoder.allowCompression(_deflateActive);
+#endif
+            _decoder.reset();
+            _decoder.allowPartial(true);
+            _attachmentsPending = 0;
+#if SOCKETIO_CAPTURE_LEN
+            {
+                uint8_t flags = 0;
+#ifdef SOCKETIO_DEFLATE
+                flags |= _deflateActive ? 1 : 0;
+#endif
+                capture(sIOcapture_WEBSOCKET, &flags, 1);
+            }
+#endif
+            if (_sid[0] == 0) {
+                // the open packet comes as the first frame
+                setState(sIOstate_OPENING);
+                return;
+            }
+            setState(sIOstate_PROBING);
+            sendCode("2probe");
+            return;
         }
-        if (index2 != -1) {
-            parser(index2);
+
+        default:
+            return;
+    }
+}
+
+/**
+ * Points client at the transport begin() asked for, unless setClient()
+ * gave it one, and sets TLS up.
+ * @return false if the interface has no TLS
+ */
+bool SocketIOClientBase::selectTransport() {
+    if (_customClient) return true;
+#if defined(ESP8266) || defined(ESP32)
+    if (_transport == sIOtransport_PLAIN) {
+        client = &_defaultClient;
+        return true;
+    }
+    client = &_secureClient;
+#if defined(ESP8266)
+    if (_trustAnchorsStale) {
+        // neither can be emptied: built again for the root_ca of the last begin() or connect(),
+        // and a session of the old one is not resumed without checking the new one
+        _trustAnchors.~X509List();
+        new (&_trustAnchors) BearSSL::X509List();
+        if (_root_ca != NULL) {
+            _trustAnchors.append(_root_ca);
         }
+        _tlsSession.~Session();
+        new (&_tlsSession) BearSSL::Session();
+        _trustAnchorsStale = false;
     }
+    if (_root_ca != NULL) {
+        _secureClient.setTrustAnchors(&_trustAnchors);
+    } else {
+        _secureClient.setInsecure();
+    }
+    // resumed by the upgrade connection and by reconnects, no full handshake
+    _secureClient.setSession(&_tlsSession);
+#else
+    if (_root_ca != NULL) {
+        _secureClient.setCACert(_root_ca);
+    } else {
+        _secureClient.setInsecure();
+    }
+#endif
+    return true;
+#else
+    return _transport == sIOtransport_PLAIN;
+#endif
 }
 
-bool SocketIOClient::waitForInput(void) {
-    unsigned long now = millis();
-    while (!client.available() && ((millis() - now) < 30000UL)) {
-        ;
+// Opens a connection, the TLS handshake included: the Arduino client API has no asynchronous connect
+bool SocketIOClientBase::openTransport() {
+    SOCKETIO_STAT(unsigned long start = micros();)
+    bool opened = client->connect(_host, _port) > 0;
+    SOCKETIO_STAT(_stats.connectTime += micros() - start;)
+    SOCKETIO_STAT(_stats.transportConnects++;)
+#if SOCKETIO_CAPTURE_LEN
+    if (opened) {
+        char address[80];
+        int length = snprintf(address, sizeof(address), "%s:%u", _host, _port);
+        capture(sIOcapture_CONNECT, address, std::min((size_t)length, sizeof(address) - 1));
     }
-    return client.available();
+#endif
+    return opened;
 }
 
-void SocketIOClient::eatHeader(void) {
-    while (client.available()) {  // consume the header
-        readLine();
-        if (strlen(databuffer) == 0) break;
+// Reads from the socket, recording what came for replay
+int SocketIOClientBase::readSocket(uint8_t *buffer, size_t size, bool messageStart, unsigned long *now) {
+    int received = client->read(buffer, size);
+    if (received > 0) {
+        capture(messageStart ? sIOcapture_IN_MESSAGE : sIOcapture_IN, buffer, received, now);
     }
+    return received;
 }
 
-bool SocketIOClient::doHandshake() {
-    uint8_t handshakeBuffer[512];
-    int size;
+size_t SocketIOClientBase::writeSocket(const uint8_t *data, size_t length) {
+    size_t written = client->write(data, length);
+    capture(sIOcapture_OUT, data, written);
+    return written;
+}
 
-    size = sprintf((char *)handshakeBuffer,
-        "GET /socket.io/1/?transport=polling&b64=true HTTP/1.1\r\n" \
+// Opens the connection and sends the long-polling handshake request
+void SocketIOClientBase::requestPolling() {
+    if (!openTransport()) {
+        fail("connect");
+        return;
+    }
+    int size = snprintf((char *)_txBuffer, _txLength,
+        "GET /socket.io/1/?EIO=%c&transport=polling&b64=true HTTP/1.1\r\n" \
         "Host: %s\r\n" \
         "Origin: Arduino\r\n" \
         "\r\n"
-    , _host);
-    client.write(handshakeBuffer, size);
+    , _eio4 ? '4' : '3', _host);
+    if ((size_t)size >= _txLength || writeSocket(_txBuffer, size) != (size_t)size) {
+        fail("request");
+        return;
+    }
+    beginHttpResponse();
+    setState(sIOstate_POLLING);
+}
 
-    if (!waitForInput()) return false;
-    
+// Asks for the WebSocket, of the polling handshake's session if there was one, on a new connection if open
+void SocketIOClientBase::requestUpgrade(bool open) {
+    if (open && !openTransport()) {
+        fail("connect");
+        return;
+    }
+    _upgradeReused = !open;
+    char extensions[160] = "";
+#ifdef SOCKETIO_DEFLATE
+    if (_compression.offer) {
+        int length = snprintf(extensions, sizeof(extensions), "Sec-WebSocket-Extensions: ");
+        length += webSocketDeflateOffer(&extensions[length], sizeof(extensions) - length);
+        snprintf(&extensions[length], sizeof(extensions) - length, "\r\n");
+    }
+    _deflateActive = false;
+    _deflateRejected = false;
+#endif
+    char session[80] = "";
+    char cookie[80] = "";
+    if (_sid[0]) {
+        snprintf(session, sizeof(session), "&sid=%s", _sid);
+        snprintf(cookie, sizeof(cookie), "Cookie: io=%s\r\n", _sid);
+    }
+    // written in two parts, the deflate offer and the session id twice do not
+    // fit a small transmit buffer at once
+    int size = snprintf((char *)_txBuffer, _txLength,
+        "GET /socket.io/1/websocket/?EIO=%c&transport=websocket%s%s HTTP/1.1\r\n" \
+        "Host: %s\r\n" \
+        "Sec-WebSocket-Version: 13\r\n" \
+        "Origin: ArduinoSocketIOClient\r\n"
+    , _eio4 ? '4' : '3', _binaryBase64 ? "&b64=true" : "", session, _host);
+    if ((size_t)size >= _txLength) {
+        fail("upgrade request");
+        return;
+    }
+    bool sent = writeSocket(_txBuffer, size) == (size_t)size;
+    if (sent) {
+        size = snprintf((char *)_txBuffer, _txLength,
+            "%s" \
+            "Sec-WebSocket-Key: IAMVERYEXCITEDESP32FTW==\r\n" \
+            "%s" \
+            "Connection: Upgrade\r\n" \
+            "Upgrade: websocket\r\n" \
+            "\r\n"
+        , extensions, cookie);
+        if ((size_t)size >= _txLength) {
+            fail("upgrade request");
+            return;
+        }
+        sent = writeSocket(_txBuffer, size) == (size_t)size;
+    }
+    if (!sent) {
+        if (_upgradeReused) {
+            upgradeOnNewConnection();
+        } else {
+            fail("upgrade request");
+        }
+        return;
+    }
+    beginHttpResponse();
+    setState(sIOstate_UPGRADING);
+}
 
-    // check for happy "HTTP/1.1 200" response
-    readLine();
-    if (atoi(&databuffer[9]) != 200) {
-        while (client.available()) readLine();
-        client.stop();
-        return false;
+// The server closed the connection the upgrade was to reuse without saying so, it is not reused again
+void SocketIOClientBase::upgradeOnNewConnection() {
+    DEBUG_WEBSOCKETS("connection closed after polling, upgrading on a new one");
+    _reuseRefused = true;
+    client->stop();
+    requestUpgrade(true);
+}
+
+void SocketIOClientBase::beginHttpResponse() {
+    _httpClose = false;
+    _httpStatus = 0;
+    _httpLength = 0;
+    _contentLength = -1;
+    _inBody = false;
+}
+
+/**
+ * Reads whatever part of the HTTP response is available. Header lines are
+ * collected in databuffer one at a time, then the body, if any, replaces them.
+ * An upgrade response ends with its headers, the bytes after them are frames.
+ * @return true once the response is complete
+ */
+bool SocketIOClientBase::readHttpResponse() {
+    while (!_inBody && client->available() > 0) {
+        uint8_t c;
+        if (readSocket(&c, 1) <= 0) break;
+        if (c == '\r') continue;
+        if (c != '\n') {
+            if (_httpLength < _rxLength - 1) {
+                databuffer[_httpLength++] = c;
+            }
+            continue;
+        }
+        databuffer[_httpLength] = 0;
+        if (_httpLength == 0) {
+            // empty line, end of the headers
+            if (_state == sIOstate_UPGRADING || _contentLength == 0) return true;
+            _inBody = true;
+            break;
+        }
+        if (_httpStatus == 0) {
+            _httpStatus = atoi(&databuffer[9]);
+        } else {
+            handleHttpHeader(databuffer);
+        }
+        _httpLength = 0;
     }
-    eatHeader();
-    readLine();
-    String tmp = databuffer;
+    if (!_inBody) return false;
 
-    int sidIndex = tmp.indexOf("sid\":\"") + 6;
-    int sidEndIndex = tmp.indexOf("\"", sidIndex);
+    int available;
+    while ((available = client->available()) > 0) {
+        size_t wanted = _rxLength - 1 - _httpLength;
+        if (_contentLength >= 0 && (size_t)_contentLength - _httpLength < wanted) {
+            wanted = _contentLength - _httpLength;
+        }
+        if (wanted > (size_t)available) {
+            wanted = available;
+        }
+        if (wanted == 0) break;
+        int received = readSocket((uint8_t *)&databuffer[_httpLength], wanted);
+        if (received <= 0) break;
+        _httpLength += received;
+    }
+    databuffer[_httpLength] = 0;
+    if (_contentLength >= 0) {
+        return _httpLength >= (size_t)_contentLength || _httpLength == _rxLength - 1;
+    }
+    // no Content-Length, the body ends with the connection
+    return !client->connected() || _httpLength == _rxLength - 1;
+}
+
+void SocketIOClientBase::handleHttpHeader(const char *line) {
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+        _contentLength = atol(&line[15]);
+    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+        _httpClose = strstr(&line[11], "close") != NULL || strstr(&line[11], "Close") != NULL;
+    } else if (strncasecmp(line, "Sec-WebSocket-Accept:", 21) == 0) {
+        const char *value = &line[21];
+        while (*value == ' ') value++;
+        size_t length = strlen(value);
+        memcpy(key, value, length < sizeof(key) ? length : sizeof(key));  //key contains the Sec-WebSocket-Accept, could be used for verification
+#ifdef SOCKETIO_DEFLATE
+    } else if (strncasecmp(line, "Sec-WebSocket-Extensions:", 25) == 0) {
+        uint8_t windowBits;
+        _deflateActive = _compression.offer && webSocketDeflateAccept(&line[25], windowBits);
+        _deflateRejected = !_deflateActive;
+        if (_deflateActive) {
+            _deflater.setWindowBits(windowBits);
+        }
+#endif
+    }
+}
+
+/**
+ * Takes the session and its heartbeat and limits from the engine.io open packet,
+ * 0{"sid":"...","upgrades":["websocket"],"pingInterval":25000,"pingTimeout":20000,"maxPayload":1000000}
+ * Missing numbers keep the engine.io defaults, maxPayload 0 is no limit.
+ * @return false without a session id, or if the server has no WebSocket to upgrade to
+ */
+bool SocketIOClientBase::parseOpenPacket(const char *packet) {
+    const char *json = strchr(packet, '{');
+    if (json == NULL) return false;
+    socketIOJsonCursor_t open(json);
+    size_t length = open["sid"].asString(_sid, sizeof(_sid));
+    if (length == 0 || length >= sizeof(_sid)) return false;
+
+    _pingInterval = open["pingInterval"].asULong(25000);
+    _pingTimeout = open["pingTimeout"].asULong(20000);
+    _maxPayload = open["maxPayload"].asULong(0);
+
+    if (_state == sIOstate_POLLING) {
+        bool websocket = false;
+        socketIOJsonCursor_t upgrades = open["upgrades"];
+        for (socketIOJsonCursor_t upgrade = upgrades.first(); upgrade.exists(); upgrade = upgrade.next()) {
+            websocket = websocket || upgrade.equals("websocket");
+        }
+        if (!websocket) {
+            DEBUG_WEBSOCKETS("no WebSocket upgrade offered");
+            return false;
+        }
+    }
+    DEBUG_WEBSOCKETS("heartbeat %lu + %lu ms, max payload %u", _pingInterval, _pingTimeout, (unsigned int)_maxPayload);
+    return true;
+}
 
-    String sid = tmp.substring(sidIndex, sidEndIndex);
+void SocketIOClientBase::loop() {
+    if (_state != sIOstate_PROBING && _state != sIOstate_OPENING && _state != sIOstate_CONNECTED) {
+        connectStep();
+        // the open packet may have come with the upgrade response, and been read with it
+        if (_state != sIOstate_OPENING) return;
+    }
+    if (!client->connected() && client->available() <= 0) {
+        fail("connection lost");
+        return;
+    }
+    if ((_state == sIOstate_PROBING || _state == sIOstate_OPENING) && timedOut(_timeouts.probe)) {
+        fail(_state == sIOstate_PROBING ? "probe timeout" : "open timeout");
+        return;
+    }
 
-    int pingIntervalIndex = tmp.indexOf("pingInterval\":") + 14;
-    int pingIntervalEndIndex = tmp.indexOf(",", pingIntervalIndex);
+    if (_state == sIOstate_CONNECTED) {
+        unsigned long now = millis();
+        // the server pings with EIO4, the client with EIO3, and the peer is
+        // dead once neither ping nor pong nor anything else came in time
+        if (_pingTimeout && now - _lastReceived >= _pingInterval + _pingTimeout && client->available() <= 0) {
+            fail("ping timeout");
+            return;
+        }
+        if (!_eio4 && now - lastPing >= _pingInterval) {
+            sendPing();
+            lastPing = now;
+        }
+    }
 
-    String pingIntervalStr = tmp.substring(pingIntervalIndex, pingIntervalEndIndex);
+    if (_ackCount && _ackPolicy.timeout) {
+        expireAcks(false);
+    }
 
-    pingInterval = pingIntervalStr.toInt();
+    // frames the flush policy held back, and what the socket did not take
+    // last time, which goes out before them anyway
+    if (_writer.length() && (_queuedFrames == 0 || millis() - _queuedSince >= _flushPolicy.maxDelay)) {
+        flushTx();
+    }
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+    if (_replay) {
+        replayOffline();
+    }
+#endif
+#if SOCKETIO_LATEST_SLOTS
+    if (_latestPending) {
+        sendLatest();
+    }
+#endif
+    if (_drainWanted && writable()) {
+        _drainWanted = false;
+        if (_drainCallback) {
+            _drainCallback();
+        }
+    }
 
-    while (client.available()) readLine();
-    client.stop();
-    delay(1000);
+#if defined(SOCKETIO_STATS) && (defined(ESP8266) || defined(ESP32))
+    size_t heap = ESP.getFreeHeap();
+    if (_stats.heapLow == 0 || heap < _stats.heapLow) {
+        _stats.heapLow = heap;
+    }
+#endif
 
+    // Read straight into the decoder, as much as it can take for the current
+    // header or payload step. Frames may end anywhere inside a read.
+    int available;
+    unsigned long readTime = 0;
+    bool receiving = false;
+    while ((available = client->available()) > 0) {
+        uint8_t *dst;
+        size_t wanted = _decoder.want(dst);
+        if (wanted > (size_t)available) {
+            wanted = available;
+        }
+        int received = readSocket(dst, wanted, _decoder.atMessageStart() && !_attachmentsPending && _streamEvent == NULL, &readTime);
+        if (received <= 0) {
+            break;
+        }
+        if (!receiving) {
+            // the heartbeat's, once per pass
+            receiving = true;
+            _lastReceived = millis();
+        }
+        SOCKETIO_STAT(_stats.bytesIn += received;)
+        switch (_decoder.commit(received)) {
+            case wsDecode_MESSAGE:
+                SOCKETIO_STAT(_stats.framesIn++;)
+                handleMessage();
+                break;
+            case wsDecode_CONTROL:
+                SOCKETIO_STAT(_stats.framesIn++;)
+                handleControl();
+                break;
+            case wsDecode_PARTIAL:
+                handlePartial();
+                break;
+            case wsDecode_ERROR:
+                fail("WebSocket protocol error");
+                return;
+            case wsDecode_NEED_MORE:
+                break;
+        }
+        if (_state == sIOstate_DISCONNECTED) return;
+    }
+}
 
-    if (!client.connect(_host, _port)) return false;
+/**
+ * The decoder's buffer is full in the middle of a message. If it is an event
+ * with a streaming handler, its data goes to the handler so far, all but the
+ * last byte, which may be the packet's closing bracket. Other messages are
+ * left to be truncated.
+ */
+void SocketIOClientBase::handlePartial() {
+    const char *payload = (const char *)_decoder.payload();
+    size_t length = _decoder.length();
+    size_t offset = 0;
+    if (_streamEvent == NULL) {
+        socketIOPacketView_t packet;
+        if (_decoder.opcode() != wsOp_TEXT || _attachmentsPending || length < 2 ||
+            payload[0] != eIOtype_MESSAGE || payload[1] != sIOtype_EVENT ||
+            !parseHead(&payload[2], length - 2, packet, offset)) return;
+        int nsp = findNamespace(packet.nsp);
+        handler_t *handler = nsp < 0 ? NULL : findHandler(packet.event, nsp);
+        if (handler == NULL || !handler->streamCallback) return;
+        DEBUG_WEBSOCKETS("Streaming event %s", handler->event);
+        SOCKETIO_STAT(_stats.events++;)
+        SOCKETIO_STAT(handler->count++;)
+        _streamEvent = handler->event;
+        _streamNsp = nsp;
+        offset += 2;
+        stream(sIOstream_BEGIN);
+    }
+    if (length > offset + 1) {
+        stream(sIOstream_DATA, &payload[offset], length - 1 - offset);
+    }
+    _decoder.discard(length - 1);
+}
 
-    size = sprintf((char *)handshakeBuffer,
-        "GET /socket.io/1/websocket/?transport=websocket&b64=true&sid=%s HTTP/1.1\r\n" \
-        "Host: %s\r\n" \
-        "Sec-WebSocket-Version: 13\r\n" \
-        "Origin: ArduinoSocketIOClient\r\n" \
-        "Sec-WebSocket-Extensions: permessage-deflate\r\n" \
-        "Sec-WebSocket-Key: IAMVERYEXCITEDESP32FTW==\r\n" \
-        "Cookie: io=%s\r\n" \
-        "Connection: Upgrade\r\n" \
-        "Upgrade: websocket\r\n" \
-        "\r\n"
-    , sid.c_str(), _host, sid.c_str());
-    client.write(handshakeBuffer, size);
-
-    if (!waitForInput()) return false;
-    readLine();
-    if (atoi(&databuffer[9]) != 101) {  // check for "HTTP/1.1 101 response, means Updrage to Websocket OK
-        while (client.available()) readLine();
-        client.stop();
+/// The end of a streamed event arrived, the last piece without the closing bracket
+bool SocketIOClientBase::streamTail() {
+    const char *payload = (const char *)_decoder.payload();
+    size_t length = _decoder.length();
+    if (_decoder.truncated() || _decoder.opcode() != wsOp_TEXT || length == 0 || payload[length - 1] != ']') {
+        stream(sIOstream_ABORT);
         return false;
     }
-    readLine();
-    readLine();
-    readLine();
-    for (int i = 0; i < 28; i++) {
-        key[i] = databuffer[i + 22];  //key contains the Sec-WebSocket-Accept, could be used for verification
+    if (length > 1) {
+        stream(sIOstream_DATA, payload, length - 1);
     }
+    stream(sIOstream_END);
+    return true;
+}
+
+void SocketIOClientBase::stream(socketIOStreamPhase_t phase, const char *data, size_t length) {
+    // looked up again every time, the handler table may change in between
+    const char *event = _streamEvent;
+    if (phase == sIOstream_END || phase == sIOstream_ABORT) {
+        _streamEvent = NULL;
+    }
+    handler_t *handler = findHandler(event, false, _streamNsp);
+    if (handler != NULL && handler->streamCallback) {
+        SOCKETIO_STAT(unsigned long start = micros();)
+        handler_t e;
+        takeCallbacks(e, *handler);
+        e.streamCallback(phase, data, length);
+        returnCallbacks(event, _streamNsp, e);
+        SOCKETIO_STAT(recordTime(_stats.dispatchTime, micros() - start);)
+    }
+}
 
-    eatHeader();
+void SocketIOClientBase::handleMessage() {
+    if (_streamEvent) {
+        streamTail();
+        return;
+    }
+    bool dropped = _decoder.truncated();
+#ifdef SOCKETIO_DEFLATE
+    if (_decoder.compressed() && !inflateMessage()) {
+        dropped = true;
+    }
+#endif
+    // attachments are binary frames, or text frames holding a base64 engine.io packet: b4...
+    if (_attachmentsPending && (_decoder.opcode() == wsOp_BINARY || _decoder.payload()[0] == 'b')) {
+        handleAttachment(dropped);
+        return;
+    }
+    if (dropped) {
+        DEBUG_WEBSOCKETS("Message longer than %d bytes dropped", _rxLength - 1);
+        return;
+    }
+    if (_decoder.opcode() != wsOp_TEXT) {
+        DEBUG_WEBSOCKETS("Binary message (%d) outside of a binary packet dropped", _decoder.length());
+        return;
+    }
+    parser((const char *)_decoder.payload(), _decoder.length());
+}
 
-    sendCode("52"); // Client has to send "52" for the upgrade to websocket
+void SocketIOClientBase::beginAttachments(socketIOmessageType_t type, const socketIOPacketView_t &packet) {
+    _binaryType = type;
+    _binaryPacket = packet;
+    _attachments.count = 0;
+    _attachmentsPending = packet.attachments;
+    _attachmentsDropped = packet.attachments > SOCKETIO_MAX_ATTACHMENTS;
+    if (_attachmentsPending == 0) {
+        handleAttachment();
+        return;
+    }
+    // keep the packet, its views are handed to the callback with the attachments
+    _decoder.retain(_decoder.payload() + _decoder.length() - (const uint8_t *)databuffer);
+}
 
+#ifdef SOCKETIO_DEFLATE
+bool SocketIOClientBase::inflateMessage() {
+    // in place, in the part of databuffer the decoder assembled the message in
+    uint8_t *message = (uint8_t *)&databuffer[_decoder.payload() - (const uint8_t *)databuffer];
+    size_t capacity = (uint8_t *)&databuffer[_rxLength - 1] - message;
+    size_t length;
+    if (_decoder.truncated() || !_inflater.inflate(message, _decoder.length(), capacity, length)) {
+#if SOCKETIO_INFLATE_WINDOW_BITS
+        fail("inflate");  // the history the next messages refer to is lost
+#endif
+        return false;
+    }
+    _decoder.setLength(length);
     return true;
 }
+#endif
 
-void SocketIOClient::readLine() {
-    for (int i = 0; i < DATA_BUFFER_LEN; i++)
-        databuffer[i] = ' ';
-    dataptr = databuffer;
-    while (client.available() && (dataptr < &databuffer[DATA_BUFFER_LEN - 2])) {
-        char c = client.read();
-        // Serial.print(c);  //Can be used for debugging
-        if (c == 0) {
-            // Serial.print("");
-        } else if (c == 255) {
-            // Serial.println("");
-        } else if (c == '\r') {
-            ;
-        } else if (c == '\n'){
+void SocketIOClientBase::handleAttachment(bool dropped) {
+    if (_attachmentsPending) {
+        _attachmentsPending--;
+        // the decoder assembled the message in databuffer, behind the retained bytes
+        uint8_t *data = (uint8_t *)&databuffer[_decoder.payload() - (const uint8_t *)databuffer];
+        size_t length = _decoder.length();
+        if (dropped) {
+            _attachmentsDropped = true;
+        } else if (_decoder.opcode() == wsOp_BINARY) {
+            // EIO 3 binary packets start with their engine.io type as a byte, EIO 4 ones are the data
+            if (_eio4) {
+                // nothing to strip
+            } else if (length == 0 || data[0] != eIOtype_MESSAGE - '0') {
+                _attachmentsDropped = true;
+            } else {
+                data++;
+                length--;
+            }
+        } else {
+            // b4<base64> with EIO 3, b<base64> with EIO 4
+            size_t skip = _eio4 ? 1 : 2;
+            if (length < skip || data[0] != 'b' || (!_eio4 && data[1] != eIOtype_MESSAGE) ||
+                !base64Decode(&data[skip], length - skip, data, length)) {
+                _attachmentsDropped = true;
+            }
+            _binaryBase64 = true;
+        }
+        if (!_attachmentsDropped) {
+            _attachments.data[_attachments.count] = data;
+            _attachments.length[_attachments.count] = length;
+            _attachments.count++;
+            _decoder.retain((char *)&data[length] - databuffer);
+        }
+        if (_attachmentsPending) return;
+    }
+    _decoder.retain(0);
+
+    if (_attachmentsDropped) {
+        DEBUG_WEBSOCKETS("Binary packet with %d attachments dropped", _binaryPacket.attachments);
+        return;
+    }
+    if (_binaryType == sIOtype_BINARY_EVENT) {
+        triggerEvent(_binaryPacket, &_attachments);
+    } else {
+        triggerAck(_binaryPacket, &_attachments);
+    }
+}
+
+void SocketIOClientBase::handleControl() {
+    switch (_decoder.opcode()) {
+        case wsOp_PING:
+            DEBUG_WEBSOCKETS("WebSocket ping received - Sending pong");
+            // like the engine.io heartbeats, it does not wait in the queue
+            sendFrame(wsOp_PONG, _decoder.payload(), _decoder.length());
+            flushTx();
+            break;
+        case wsOp_CLOSE:
+            DEBUG_WEBSOCKETS("WebSocket close received");
+            // echo the status code, if any, before closing the transport
+            sendFrame(wsOp_CLOSE, _decoder.payload(), _decoder.length() >= 2 ? 2 : 0);
+            flushTx();
+            fail("closed by server");
+            break;
+        default:
             break;
-        }else
-            *dataptr++ = c;
     }
-    *dataptr = 0;
 }
 
-void SocketIOClient::emit(const char *event, const char *content, ackCallback_fn cb) {
+bool SocketIOClientBase::emit(const char *event, const char *content, ackCallback_fn cb) {
+	return emitTo(0, event, content, cb);
+}
+
+bool SocketIOClientBase::emitBinary(const char *event, const uint8_t *data, size_t length, binaryAckCallback_fn cb) {
+	return emitBinaryTo(0, event, data, length, cb);
+}
+
+bool SocketIOClientBase::emitTo(uint8_t nsp, const char *event, const char *content, ackCallback_fn cb) {
+	const char *name = nsp ? _namespaces[nsp]._name : NULL;
+	if (nsp && !_namespaces[nsp]._connected) {
+		_droppedFrames++;
+		return false;
+	}
+	if (cb == NULL) {
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+		// behind the events still waiting, so they all go out in order
+		if (nsp == 0 && (_state != sIOstate_CONNECTED || _offlineCount)) {
+			return bufferOffline(event, content);
+		}
+#endif
+		return sendPacket(sIOtype_EVENT, event, content, socketIOView_t(), 0, name);
+	}
+	ack_t evicted;
+	ack_t *ack = addAck(evicted);
+	if (ack == NULL) return false;
+	ack->nsp = nsp;
+	ack->callback = cb;
+	char ackId[12];
+	snprintf(ackId, sizeof(ackId), "%lu", (unsigned long)ack->id);
+	bool sent = sendPacket(sIOtype_EVENT, event, content, ackId, 0, name);
+	if (!sent) {
+		*ack = ack_t();
+		_ackCount--;
+	}
+	expireAck(evicted);
+	return sent;
+}
+
+bool SocketIOClientBase::emitBinaryTo(uint8_t nsp, const char *event, const uint8_t *data, size_t length, binaryAckCallback_fn cb) {
+	const char *name = nsp ? _namespaces[nsp]._name : NULL;
+	if (nsp && !_namespaces[nsp]._connected) {
+		_droppedFrames++;
+		return false;
+	}
 	if (cb == NULL) {
-		String message = constructMESSAGE(sIOtype_EVENT, event, content);	
-		sendMESSAGE(message);
-	} else {
-		String ackId(_ackId++);
-		String message = constructMESSAGE(sIOtype_EVENT, event, content, ackId.c_str());
-		_acks[ackId.c_str()] = cb;
-		sendMESSAGE(message);
+		return sendBinary(sIOtype_BINARY_EVENT, event, data, length, socketIOView_t(), name);
 	}
+	ack_t evicted;
+	ack_t *ack = addAck(evicted);
+	if (ack == NULL) return false;
+	ack->nsp = nsp;
+	ack->binaryCallback = cb;
+	char ackId[12];
+	snprintf(ackId, sizeof(ackId), "%lu", (unsigned long)ack->id);
+	bool sent = sendBinary(sIOtype_BINARY_EVENT, event, data, length, ackId, name);
+	if (!sent) {
+		*ack = ack_t();
+		_ackCount--;
+	}
+	expireAck(evicted);
+	return sent;
+}
+
+#if SOCKETIO_LATEST_SLOTS
+bool SocketIOClientBase::emitLatest(const char *event, const char *content, unsigned long minInterval, const char *key) {
+    if (key == NULL) key = event;
+    size_t keyLength = strlen(key) + 1;
+    size_t eventLength = strlen(event) + 1;
+    size_t contentLength = content ? strlen(content) + 1 : 0;
+    if (keyLength + eventLength + contentLength > SOCKETIO_LATEST_LEN) {
+        DEBUG_WEBSOCKETS("Latest value of %s too long", key);
+        return false;
+    }
+    latest_t *slot = findLatest(key);
+    if (slot == NULL) {
+        for (size_t i = 0; i < SOCKETIO_LATEST_SLOTS && slot == NULL; i++) {
+            if (!_latest[i].used) slot = &_latest[i];
+        }
+        if (slot == NULL) return false;
+        slot->used = true;
+        slot->hash = socketIOHash(socketIOView_t(key, keyLength - 1));
+        slot->superseded = 0;
+        slot->sentAt = millis() - minInterval;
+        memcpy(slot->data, key, keyLength);
+    } else if (slot->pending) {
+        slot->superseded++;
+        _supersededEvents++;
+    }
+    slot->minInterval = minInterval;
+    slot->event = keyLength;
+    slot->content = keyLength + eventLength;
+    slot->hasContent = content != NULL;
+    memcpy(&slot->data[slot->event], event, eventLength);
+    if (content) {
+        memcpy(&slot->data[slot->content], content, contentLength);
+    }
+    slot->pending = true;
+    _latestPending = true;
+    sendLatest();
+    return true;
+}
+
+unsigned long SocketIOClientBase::supersededEvents(const char *key) const {
+    if (key == NULL) return _supersededEvents;
+    latest_t *slot = const_cast<SocketIOClientBase *>(this)->findLatest(key);
+    return slot ? slot->superseded : 0;
+}
+
+void SocketIOClientBase::forgetLatest(const char *key) {
+    latest_t *slot = findLatest(key);
+    if (slot) {
+        *slot = latest_t();
+    }
+}
+
+SocketIOClientBase::latest_t *SocketIOClientBase::findLatest(const char *key) {
+    uint32_t hash = socketIOHash(socketIOView_t(key, strlen(key)));
+    for (size_t i = 0; i < SOCKETIO_LATEST_SLOTS; i++) {
+        if (_latest[i].used && _latest[i].hash == hash && strcmp(_latest[i].data, key) == 0) {
+            return &_latest[i];
+        }
+    }
+    return NULL;
+}
+
+// Sends the values due, as long as the socket keeps up
+void SocketIOClientBase::sendLatest() {
+    if (_state != sIOstate_CONNECTED) return;
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+    // what was held offline goes first
+    if (_offlineCount) return;
+#endif
+    bool pending = false;
+    unsigned long now = millis();
+    for (size_t i = 0; i < SOCKETIO_LATEST_SLOTS; i++) {
+        latest_t &slot = _latest[i];
+        if (!slot.pending) continue;
+        if (now - slot.sentAt < slot.minInterval || !writable() ||
+            !sendPacket(sIOtype_EVENT, &slot.data[slot.event], slot.hasContent ? &slot.data[slot.content] : NULL)) {
+            pending = true;
+            continue;
+        }
+        slot.pending = false;
+        slot.sentAt = now;
+    }
+    _latestPending = pending;
 }
+#endif
 
-void SocketIOClient::send(const char *content) {
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+bool SocketIOClientBase::bufferOffline(const char *event, const char *content, bool packet) {
+    size_t eventLength = strlen(event) + 1;
+    size_t contentLength = content ? strlen(content) + 1 : 0;
+    size_t length = 3 + eventLength + contentLength;
+    if (length > SOCKETIO_OFFLINE_BUFFER_LEN || length > 0xFFFF) {
+        _droppedEvents++;
+        return false;
+    }
+    while (SOCKETIO_OFFLINE_BUFFER_LEN - _offlineLength < length) {
+        DEBUG_WEBSOCKETS("offline buffer full, oldest event dropped");
+        dropOffline();
+        _droppedEvents++;
+    }
+    const uint8_t header[3] = { (uint8_t)(length >> 8), (uint8_t)length, (uint8_t)(packet ? 2 : content != NULL) };
+    putOffline(header, 3);
+    putOffline(event, eventLength);
+    if (content) putOffline(content, contentLength);
+    _offlineCount++;
+    return true;
+}
+
+void SocketIOClientBase::putOffline(const void *data, size_t length) {
+    if (length == 0) return;
+    size_t tail = (_offlineHead + _offlineLength) % SOCKETIO_OFFLINE_BUFFER_LEN;
+    size_t n = std::min(length, (size_t)SOCKETIO_OFFLINE_BUFFER_LEN - tail);
+    memcpy(&_offline[tail], data, n);
+    memcpy(_offline, (const uint8_t *)data + n, length - n);
+    _offlineLength += length;
+}
+
+size_t SocketIOClientBase::offlineRecordLength() const {
+    return _offline[_offlineHead] << 8 | _offline[(_offlineHead + 1) % SOCKETIO_OFFLINE_BUFFER_LEN];
+}
+
+void SocketIOClientBase::dropOffline() {
+    size_t length = offlineRecordLength();
+    _offlineHead = (_offlineHead + length) % SOCKETIO_OFFLINE_BUFFER_LEN;
+    _offlineLength -= length;
+    _offlineCount--;
+}
+
+/**
+ * Sends the held events as far as the transmit buffer stays writable, the
+ * next loop() goes on with the rest. Records are sent in place, the buffer
+ * is rotated when the oldest one wraps around its end.
+ */
+void SocketIOClientBase::replayOffline() {
+    while (_offlineCount && writable()) {
+        if (_offlineHead + offlineRecordLength() > SOCKETIO_OFFLINE_BUFFER_LEN) {
+            std::rotate(_offline, &_offline[_offlineHead], &_offline[SOCKETIO_OFFLINE_BUFFER_LEN]);
+            _offlineHead = 0;
+        }
+        const char *event = (const char *)&_offline[_offlineHead + 3];
+        uint8_t flag = _offline[_offlineHead + 2];
+        if (flag == 2) {
+            if (!sendFrame(wsOp_TEXT, (const uint8_t *)event, strlen(event))) return;
+        } else if (!sendPacket(sIOtype_EVENT, event, flag ? event + strlen(event) + 1 : NULL)) {
+            return;
+        }
+        dropOffline();
+    }
+    _replay = _offlineCount > 0;
+}
+#endif
+
+/**
+ * Takes a free slot, or the oldest one if the policy allows it. Its previous
+ * ack is moved to evicted, to be expired once the new one is set up.
+ */
+SocketIOClientBase::ack_t *SocketIOClientBase::addAck(ack_t &evicted) {
+    if (_state != sIOstate_CONNECTED) return NULL;
+    ack_t *slot = NULL;
+    for (size_t i = 0; i < _maxAcks && slot == NULL; i++) {
+        if (_acks[i].id == 0) slot = &_acks[i];
+    }
+    if (slot == NULL) {
+        if (!_ackPolicy.evictOldest) {
+            DEBUG_WEBSOCKETS("No room for another ack, event dropped");
+            return NULL;
+        }
+        slot = &_acks[0];
+        for (size_t i = 1; i < _maxAcks; i++) {
+            if (millis() - _acks[i].since > millis() - slot->since) slot = &_acks[i];
+        }
+        DEBUG_WEBSOCKETS("No room for another ack, giving up on ack %lu", (unsigned long)slot->id);
+        std::swap(evicted, *slot);
+        _ackCount--;
+    }
+    if (++_ackId == 0) _ackId = 1;
+    slot->id = _ackId;
+    slot->since = millis();
+    _ackCount++;
+    return slot;
+}
+
+void SocketIOClientBase::expireAck(ack_t &ack) {
+    if (ack.callback) {
+        ack.callback(NULL);
+    }
+    if (ack.binaryCallback) {
+        socketIOAttachments_t none;
+        ack.binaryCallback(socketIOView_t(), none);
+    }
+}
+
+void SocketIOClientBase::expireAcks(bool all, int nsp) {
+    for (size_t i = 0; i < _maxAcks && _ackCount; i++) {
+        if (_acks[i].id == 0 || (nsp >= 0 && _acks[i].nsp != nsp) ||
+            (!all && millis() - _acks[i].since < _ackPolicy.timeout)) continue;
+        DEBUG_WEBSOCKETS("No answer to ack %lu", (unsigned long)_acks[i].id);
+        // the slot is free before the callback runs, it may emit again
+        ack_t ack;
+        std::swap(ack, _acks[i]);
+        _ackCount--;
+        expireAck(ack);
+    }
+}
+
+void SocketIOClientBase::send(const char *content) {
     emit("message", content);
 }
 
-void SocketIOClient::on(const char *event, callback_fn func) {
-    _events[event] = func;
+SocketIOClientBase::handler_t *SocketIOClientBase::findHandler(const char *event, bool create, uint8_t nsp) {
+    uint32_t hash = socketIOHash(event);
+    size_t i = 0;
+    while (i < _handlerCount && _handlers[i].hash < hash) i++;
+    for (size_t j = i; j < _handlerCount && _handlers[j].hash == hash; j++) {
+        if (_handlers[j].nsp == nsp && strcmp(_handlers[j].event, event) == 0) return &_handlers[j];
+    }
+    if (!create) return NULL;
+    if (_handlerCount == _maxHandlers) {
+        DEBUG_WEBSOCKETS("No room for the handler of %s", event);
+        return NULL;
+    }
+    for (size_t j = _handlerCount; j > i; j--) {
+        _handlers[j] = _handlers[j - 1];
+    }
+    _handlerCount++;
+    _handlers[i] = handler_t();
+    _handlers[i].hash = hash;
+    _handlers[i].nsp = nsp;
+    _handlers[i].event = event;
+    return &_handlers[i];
+}
+
+/// The handler of the event, without the callbacks given to it before, of whatever kind
+SocketIOClientBase::handler_t *SocketIOClientBase::replaceHandler(const char *event, uint8_t nsp) {
+    handler_t *handler = findHandler(event, true, nsp);
+    if (handler != NULL) {
+        handler->callback = nullptr;
+        handler->viewCallback = nullptr;
+        handler->binaryCallback = nullptr;
+        handler->streamCallback = nullptr;
+    }
+    return handler;
+}
+
+bool SocketIOClientBase::on(const char *event, callback_fn func) {
+    return _namespaces[0].on(event, func);
+}
+
+bool SocketIOClientBase::on(const char *event, viewCallback_fn func) {
+    return _namespaces[0].on(event, func);
+}
+
+bool SocketIOClientBase::on(const char *event, binaryCallback_fn func) {
+    return _namespaces[0].on(event, func);
+}
+
+bool SocketIOClientBase::on(const char *event, streamCallback_fn func) {
+    return _namespaces[0].on(event, func);
+}
+
+SocketIOClientBase::handler_t *SocketIOClientBase::findHandler(const socketIOView_t &event, uint8_t nsp) {
+    uint32_t hash = socketIOHash(event);
+    size_t lo = 0;
+    size_t hi = _handlerCount;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (_handlers[mid].hash < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (; lo < _handlerCount && _handlers[lo].hash == hash; lo++) {
+        if (_handlers[lo].nsp == nsp && event.equals(_handlers[lo].event)) return &_handlers[lo];
+    }
+    return NULL;
 }
 
-void SocketIOClient::sendCode(const String& code) {
-    int length = 6 + code.length();
-    uint8_t codeBuffer[length];
-     /*
-	Generating a 32 bits mask requiered for newer version
-	*/
-    randomSeed(analogRead(0));
-    codeBuffer[0] = 0x81; //has to be sent for proper communication
-    codeBuffer[1] = code.length() + 128; //size of the message + 128 because message has to be masked
+void SocketIOClientBase::setHandlers(const socketIOHandler_t *handlers, size_t count) {
+    _staticHandlers = handlers;
+    _staticHandlerCount = count;
+}
+
+void SocketIOClientBase::clear() {
+    for (size_t i = 0; i < _handlerCount; i++) {
+        _handlers[i] = handler_t();
+    }
+    _handlerCount = 0;
+    _staticHandlers = NULL;
+    _staticHandlerCount = 0;
+}
 
-    String mask = "";
-    for (int i = 0; i < 4; i++)  //generate a random mask, 4 bytes, ASCII 0 to 9
-    {
-        char a = random(48, 57);
-        codeBuffer[i + 2] = a;
-        mask += a;
+SocketIONamespace *SocketIOClientBase::of(const char *nsp) {
+    int index = findNamespace(nsp);
+    if (index >= 0) return &_namespaces[index];
+    if (_namespaceCount == SOCKETIO_MAX_NAMESPACES) {
+        DEBUG_WEBSOCKETS("No room for namespace %s", nsp);
+        return NULL;
     }
+    SocketIONamespace &ns = _namespaces[_namespaceCount];
+    ns._client = this;
+    ns._name = nsp;
+    ns._index = _namespaceCount++;
+    ns.join();
+    return &ns;
+}
+
+int SocketIOClientBase::findNamespace(const socketIOView_t &nsp) const {
+    if (nsp.empty() || nsp.equals("/")) return 0;
+    for (size_t i = 1; i < _namespaceCount; i++) {
+        if (nsp.equals(_namespaces[i]._name)) return i;
+    }
+    return -1;
+}
 
-    for (int i = 0; i < code.length(); i++)
-        codeBuffer[i + 6] = code[i] ^ mask[i % 4];  //apply the "mask" to the code
+/// 40/namespace, or 41/namespace,
+void SocketIOClientBase::sendNamespace(socketIOmessageType_t type, uint8_t nsp) {
+    const char *name = _namespaces[nsp]._name;
+    size_t length = strlen(name);
+    const char header[2] = { (char)eIOtype_MESSAGE, (char)type };
+    if (!beginFrame(wsOp_TEXT, 2 + length + 1)) return;
+    appendFrame(header, 2);
+    appendFrame(name, length);
+    appendFrame(",", 1);
+    endFrame();
+}
+
+void SocketIOClientBase::namespaceConnected(uint8_t nsp, bool connected) {
+    _namespaces[nsp]._connected = connected;
+    if (!connected) {
+        expireAcks(true, nsp);
+        return;
+    }
+    if (nsp != 0) return;
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+    _replay = _offlineCount > 0;
+#endif
+    // the other namespaces are joined over the default one
+    for (size_t i = 1; i < _namespaceCount; i++) {
+        if (_namespaces[i]._joined) {
+            sendNamespace(sIOtype_CONNECT, i);
+        }
+    }
+}
 
-    client.write(codeBuffer, length);
+void SocketIONamespace::join() {
+    _joined = true;
+    if (_index && !_connected && _client->_namespaces[0]._connected) {
+        _client->sendNamespace(sIOtype_CONNECT, _index);
+    }
 }
 
-void SocketIOClient::sendPing() {
+void SocketIONamespace::leave() {
+    if (_index == 0) return;
+    _joined = false;
+    if (_connected) {
+        _client->sendNamespace(sIOtype_DISCONNECT, _index);
+        _client->namespaceConnected(_index, false);
+    }
+}
+
+bool SocketIONamespace::emit(const char *event, const char *content, ackCallback_fn cb) {
+    return _client->emitTo(_index, event, content, cb);
+}
+
+bool SocketIONamespace::emitBinary(const char *event, const uint8_t *data, size_t length, binaryAckCallback_fn cb) {
+    return _client->emitBinaryTo(_index, event, data, length, cb);
+}
+
+bool SocketIONamespace::on(const char *event, callback_fn func) {
+    SocketIOClientBase::handler_t *handler = _client->replaceHandler(event, _index);
+    if (handler == NULL) return false;
+    handler->callback = func;
+    return true;
+}
+
+bool SocketIONamespace::on(const char *event, viewCallback_fn func) {
+    SocketIOClientBase::handler_t *handler = _client->replaceHandler(event, _index);
+    if (handler == NULL) return false;
+    handler->viewCallback = func;
+    return true;
+}
+
+bool SocketIONamespace::on(const char *event, binaryCallback_fn func) {
+    SocketIOClientBase::handler_t *handler = _client->replaceHandler(event, _index);
+    if (handler == NULL) return false;
+    handler->binaryCallback = func;
+    return true;
+}
+
+bool SocketIONamespace::on(const char *event, streamCallback_fn func) {
+    SocketIOClientBase::handler_t *handler = _client->replaceHandler(event, _index);
+    if (handler == NULL) return false;
+    handler->streamCallback = func;
+    return true;
+}
+
+void SocketIOClientBase::sendCode(const char *code) {
+    // heartbeats and upgrades are time critical, they do not wait in the queue
+    sendFrame(wsOp_TEXT, (const uint8_t *)code, strlen(code));
+    flushTx();
+}
+
+void SocketIOClientBase::sendPing() {
     sendCode("2"); // ping
+#ifdef SOCKETIO_STATS
+    _pingSent = micros();
+    _pingPending = true;
+#endif
 }
 
-void SocketIOClient::sendPong() {
+void SocketIOClientBase::sendPong() {
     sendCode("3"); // pong
 }
 
-void SocketIOClient::triggerEvent(const socketIOPacket_t &packet) {
-    auto e = _events.find(packet.event.c_str());
-    DEBUG_WEBSOCKETS("Trigger event %s", packet.event.c_str());
-    DEBUG_WEBSOCKETS("Event payload %s", packet.data.c_str());
-    if (e != _events.end()) {
-        ackCallback_fn cb = [this, packet](const char *cb_payload) {
-            const String msg = constructMESSAGE(sIOtype_ACK, packet.event.c_str(), cb_payload, packet.id.c_str());
-            sendMESSAGE(msg);
-        };
-        e->second(packet.data, cb);
+bool SocketIOClientBase::parsePacket(socketIOmessageType_t type, const char *payload, size_t length, socketIOPacketView_t &packet) {
+    SOCKETIO_STAT(unsigned long start = micros();)
+    bool parsed = parse(type, payload, length, packet);
+    SOCKETIO_STAT(recordTime(_stats.parseTime, micros() - start);)
+    return parsed;
+}
+
+/**
+ * Callbacks run out of the handler table, which on() called from them may
+ * move or change: they are swapped out for the call, without a copy, and
+ * put back after it unless on() gave the event others meanwhile.
+ */
+void SocketIOClientBase::takeCallbacks(handler_t &to, handler_t &from) {
+    std::swap(to.callback, from.callback);
+    std::swap(to.viewCallback, from.viewCallback);
+    std::swap(to.binaryCallback, from.binaryCallback);
+    std::swap(to.streamCallback, from.streamCallback);
+}
+
+void SocketIOClientBase::returnCallbacks(const char *event, uint8_t nsp, handler_t &callbacks) {
+    handler_t *handler = findHandler(event, false, nsp);
+    if (handler != NULL && !handler->callback && !handler->viewCallback &&
+        !handler->binaryCallback && !handler->streamCallback) {
+        takeCallbacks(*handler, callbacks);
+    }
+}
+
+void SocketIOClientBase::triggerEvent(const socketIOPacketView_t &packet, const socketIOAttachments_t *attachments) {
+    SOCKETIO_STAT(_stats.events++;)
+    SOCKETIO_STAT(unsigned long start = micros();)
+    dispatchEvent(packet, attachments);
+    SOCKETIO_STAT(recordTime(_stats.dispatchTime, micros() - start);)
+}
+
+void SocketIOClientBase::dispatchEvent(const socketIOPacketView_t &packet, const socketIOAttachments_t *attachments) {
+    DEBUG_WEBSOCKETS("Trigger event %.*s", (int)packet.event.length, packet.event.ptr);
+    DEBUG_WEBSOCKETS("Event payload %.*s", (int)packet.data.length, packet.data.ptr);
+    int nsp = findNamespace(packet.nsp);
+    if (nsp < 0) {
+        DEBUG_WEBSOCKETS("Event for namespace %.*s not joined", (int)packet.nsp.length, packet.nsp.ptr);
+        return;
+    }
+    if (nsp == 0 && _eventSink) {
+        _eventSink(packet);
+        return;
+    }
+    socketIOAck_t ack(this, &packet);
+    handler_t *handler = findHandler(packet.event, nsp);
+    if (handler != NULL) {
+        SOCKETIO_STAT(handler->count++;)
+        const char *event = handler->event;
+        handler_t e;
+        takeCallbacks(e, *handler);
+        if (e.viewCallback) {
+            e.viewCallback(packet.data, ack);
+        }
+        if (e.binaryCallback) {
+            socketIOAttachments_t none;
+            e.binaryCallback(packet.data, attachments ? *attachments : none, ack);
+        }
+        if (e.callback) {
+            // the String interface keeps its copies, its ack may be called later
+            String id = packet.id.toString();
+            String name = packet.nsp.toString();
+            ackCallback_fn cb = [this, id, name](const char *cb_payload) {
+                if (id.length()) {
+                    sendPacket(sIOtype_ACK, socketIOView_t(), cb_payload, id.c_str(), 0, name.c_str());
+                }
+            };
+            e.callback(packet.data.unquoted().toString(), cb);
+        }
+        if (e.streamCallback) {
+            e.streamCallback(sIOstream_BEGIN, NULL, 0);
+            e.streamCallback(sIOstream_DATA, packet.data.ptr, packet.data.length);
+            e.streamCallback(sIOstream_END, NULL, 0);
+        }
+        returnCallbacks(event, nsp, e);
+        return;
+    }
+
+    if (nsp != 0) return;
+    uint32_t hash = socketIOHash(packet.event);
+    for (size_t i = 0; i < _staticHandlerCount; i++) {
+        const socketIOHandler_t &e = _staticHandlers[i];
+        if (e.hash == hash && packet.event.equals(e.event)) {
+            e.handler(packet.data, ack);
+            return;
+        }
+    }
+}
+
+void socketIOAck_t::operator()(const char *payload) const {
+    if (requested()) {
+        _client->sendPacket(sIOtype_ACK, socketIOView_t(), payload, _packet->id, 0, _packet->nsp);
+    }
+}
+
+void socketIOAck_t::operator()(const uint8_t *data, size_t length) const {
+    if (requested()) {
+        _client->sendBinary(sIOtype_BINARY_ACK, socketIOView_t(), data, length, _packet->id, _packet->nsp);
     }
 }
 
-void SocketIOClient::triggerAck(const socketIOPacket_t &packet) {
-    auto e = _acks.find(packet.id.c_str());
-    if (e != _acks.end()) {
-        e->second(packet.event.c_str()); // <- should be data
-		_acks.erase(e);
+void SocketIOClientBase::triggerAck(const socketIOPacketView_t &packet, const socketIOAttachments_t *attachments) {
+    if (packet.id.empty() || packet.id.length > 10) return;
+    uint32_t id = 0;
+    for (size_t i = 0; i < packet.id.length; i++) {
+        id = id * 10 + (packet.id.ptr[i] - '0');
+    }
+    int nsp = findNamespace(packet.nsp);
+    for (size_t i = 0; i < _maxAcks; i++) {
+        if (_acks[i].id != id || id == 0 || _acks[i].nsp != nsp) continue;
+        ack_t ack;
+        std::swap(ack, _acks[i]);
+        _ackCount--;
+        SOCKETIO_STAT(unsigned long start = micros();)
+        if (ack.binaryCallback) {
+            socketIOAttachments_t none;
+            ack.binaryCallback(packet.data, attachments ? *attachments : none);
+        } else if (ack.callback) {
+            socketIOView_t data = packet.data.unquoted();
+            if (data.ptr >= databuffer && data.ptr + data.length < databuffer + _rxLength) {
+                // terminated in place, over the closing quote or bracket behind it
+                char *end = (char *)&data.ptr[data.length];
+                char saved = *end;
+                *end = 0;
+                ack.callback(data.ptr);
+                *end = saved;
+            } else {
+                ack.callback(data.toString().c_str());
+            }
+        }
+        SOCKETIO_STAT(recordTime(_stats.dispatchTime, micros() - start);)
+        return;
     }
+    DEBUG_WEBSOCKETS("Ack %.*s is not pending", (int)packet.id.length, packet.id.ptr);
 }
 
-String SocketIOClient::constructMESSAGE(socketIOmessageType_t type, const char *event, const char *payload, const char *id) {
-    String msg = String((char)eIOtype_MESSAGE) + String((char)type);
-    if (id) {
-        msg += id;
+/// Length of a masked client frame with its header
+static size_t frameLength(size_t length) {
+    return (length <= 125 ? 6 : length <= 65535 ? 8 : 14) + length;
+}
+
+bool SocketIOClientBase::sendPacket(socketIOmessageType_t type, const socketIOView_t &event, const char *payload, const socketIOView_t &id, size_t attachments, const socketIOView_t &nsp, size_t following) {
+    if (_state != sIOstate_CONNECTED) {
+        _droppedFrames += 1 + attachments;
+        return false;
+    }
+    DEBUG_WEBSOCKETS("send packet %c: %.*s %s", type, (int)event.length, event.ptr, payload ? payload : "");
+    // 4 5 N- for binary packets
+    char header[16] = { (char)eIOtype_MESSAGE, (char)type };
+    size_t headerLength = 2;
+    if (attachments) {
+        headerLength += snprintf(&header[2], sizeof(header) - 2, "%u-", (unsigned int)attachments);
+    }
+    // the default namespace goes without its name
+    size_t nspLength = nsp.equals("/") ? 0 : nsp.length;
+    // acks answer with the payload alone, the event is not theirs to name
+    bool ack = type == sIOtype_ACK || type == sIOtype_BINARY_ACK;
+    size_t eventLength = event.length;
+    size_t idLength = id.length;
+    size_t payloadLength = payload ? strlen(payload) : 0;
+    bool quote = payload && payload[0] != '{' && payload[0] != '[';
+
+    // 42/namespace,id["event",payload] or 43/namespace,id[payload]
+    size_t length = headerLength + (nspLength ? nspLength + 1 : 0) + idLength + 2;
+    if (!ack) {
+        length += 2 + eventLength;
+    }
+    if (payload) {
+        length += (ack ? 0 : 1) + payloadLength + (quote ? 2 : 0);
+    }
+
+    if (!beginFrame(wsOp_TEXT, length, following)) {
+        _droppedFrames += attachments;
+        return false;
+    }
+    appendFrame(header, headerLength);
+    if (nspLength) {
+        appendFrame(nsp.ptr, nspLength);
+        appendFrame(",", 1);
+    }
+    appendFrame(id.ptr, idLength);
+    appendFrame("[", 1);
+    if (!ack) {
+        appendFrame("\"", 1);
+        appendFrame(event.ptr, eventLength);
+        appendFrame("\"", 1);
     }
-    msg += "[\"";
-    msg += event;
-    msg += "\"";
     if (payload) {
-        msg += ",";
-        if (payload[0] != '{' && payload[0] != '[')
-            msg += "\"";
-        msg += payload;
-        if (payload[0] != '{' && payload[0] != '[')
-            msg += "\"";
-    }
-    msg += "]";
-    return msg;
-}
-
-void SocketIOClient::sendMESSAGE(const String &message) {
-	DEBUG_WEBSOCKETS("send message (%d): %s", message.length(), message.c_str());
-    int msglength = message.length();
-    uint8_t messageBuffer[10 + 4 + msglength];
-    messageBuffer[0] = 0x81;  // has to be sent for proper communication
-                              // Depending on the size of the message
-                                    
-    int index;
-    if (msglength <= 125) {
-        messageBuffer[1] = msglength + 128; //size of the message + 128 because message has to be masked
-        index = 2;
-    } else if (msglength >= 126 && msglength <= 65535) {
-        messageBuffer[1] = 126 + 128;
-        messageBuffer[2] = (msglength >> 8) & 255;
-        messageBuffer[3] = (msglength)&255;
-        index = 4;
+        if (!ack)
+            appendFrame(",", 1);
+        if (quote)
+            appendFrame("\"", 1);
+        appendFrame(payload, payloadLength);
+        if (quote)
+            appendFrame("\"", 1);
+    }
+    appendFrame("]", 1);
+    // the attachments follow in the same write
+    endFrame(attachments > 0);
+    return !_txAborted;
+}
+
+bool SocketIOClientBase::sendBinary(socketIOmessageType_t type, const socketIOView_t &event, const uint8_t *data, size_t length, const socketIOView_t &id, const socketIOView_t &nsp) {
+    size_t attachment = _binaryBase64 ? (_eio4 ? 1 : 2) + (length + 2) / 3 * 4 : (_eio4 ? 0 : 1) + length;
+    if (_maxPayload && attachment > _maxPayload) {
+        // checked before the packet, which would otherwise wait for it forever
+        DEBUG_WEBSOCKETS("attachment longer than the server's maxPayload dropped");
+        _droppedFrames += 2;
+        return false;
+    }
+    // the packet is only queued with room for its attachment behind it
+    if (!sendPacket(type, event, "{\"_placeholder\":true,\"num\":0}", id, 1, nsp, frameLength(attachment))) return false;
+    return sendAttachment(data, length);
+}
+
+bool SocketIOClientBase::sendAttachment(const uint8_t *data, size_t length) {
+    if (!_binaryBase64) {
+        // EIO 3 binary packet: the engine.io type as a byte, then the data, EIO 4 the data alone
+        const uint8_t type = eIOtype_MESSAGE - '0';
+        size_t head = _eio4 ? 0 : 1;
+        if (!beginFrame(wsOp_BINARY, head + length)) return false;
+        appendFrame(&type, head);
+        appendFrame(data, length);
+        endFrame();
+        return !_txAborted;
+    }
+
+    // b4<base64> (b<base64> with EIO 4), encoded in pieces straight into the frame
+    size_t head = _eio4 ? 1 : 2;
+    if (!beginFrame(wsOp_TEXT, head + (length + 2) / 3 * 4)) return false;
+    appendFrame("b4", head);
+    char encoded[64];
+    while (length) {
+        size_t n = length < 48 ? length : 48;
+        appendFrame(encoded, base64Encode(data, n, encoded));
+        data += n;
+        length -= n;
+    }
+    endFrame();
+    return !_txAborted;
+}
+
+bool SocketIOClientBase::sendFrame(wsOpcode_t opcode, const uint8_t *payload, size_t length) {
+    if (!beginFrame(opcode, length)) return false;
+    appendFrame(payload, length);
+    endFrame();
+    return !_txAborted;
+}
+
+socketIOJsonWriter_t SocketIOClientBase::emitWriter() {
+    // one byte is left for a terminator, for the offline buffer
+    size_t start = _writer.length() + WS_MAX_HEADER_LEN;
+    size_t capacity = start < _txLength ? _txLength - start - 1 : 0;
+    return socketIOJsonWriter_t((char *)&_txBuffer[start < _txLength ? start : 0], capacity);
+}
+
+/// @return true if flushing may have made room for another attempt
+bool SocketIOClientBase::emitRoom() {
+    if (_writer.length() == 0) return false;
+    flushTx();
+    return true;
+}
+
+void SocketIOClientBase::emitHead(socketIOJsonWriter_t &out, uint8_t nsp, const char *event) {
+    out.raw("42", 2);
+    if (nsp) {
+        out.raw(_namespaces[nsp]._name);
+        out.raw(",", 1);
+    }
+    out.raw("[", 1);
+    out.string(event);
+}
+
+void SocketIOClientBase::emitHead(socketIOJsonWriter_t &out, uint8_t nsp, const socketIOEvent_t &event) {
+    if (nsp == 0) {
+        out.raw(event.prefix, event.prefixLength);
+        return;
+    }
+    out.raw("42", 2);
+    out.raw(_namespaces[nsp]._name);
+    out.raw(",", 1);
+    // the prefix without its 42
+    out.raw(event.prefix + 2, event.prefixLength - 2);
+}
+
+bool SocketIOClientBase::emitSerialized(const socketIOJsonWriter_t &out, uint8_t nsp) {
+    if (nsp && !_namespaces[nsp]._connected) {
+        _droppedFrames++;
+        return false;
+    }
+    return sendSerialized((char *)out.data(), out.length(), nsp == 0);
+}
+
+/**
+ * Sends a serialized event packet, or holds it in the offline buffer.
+ * @param packet with room for a terminator behind it, for the offline buffer
+ */
+bool SocketIOClientBase::sendSerialized(char *packet, size_t length, bool hold) {
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+    if (hold && (_state != sIOstate_CONNECTED || _offlineCount)) {
+        packet[length] = 0;
+        return bufferOffline(packet, NULL, true);
+    }
+#endif
+    (void)hold;
+    if (_state != sIOstate_CONNECTED) {
+        _droppedFrames++;
+        return false;
+    }
+    // beginFrame() puts the header in front of the packet, which append() moves behind it
+    return sendFrame(wsOp_TEXT, (const uint8_t *)packet, length);
+}
+
+bool SocketIOClientBase::emitOverflow() {
+    DEBUG_WEBSOCKETS("Event longer than the transmit buffer dropped");
+    _droppedFrames++;
+    return false;
+}
+
+/**
+ * Frames are queued whole or not at all, so a socket that stops taking data
+ * never leaves half a frame behind and loop() never waits for it: without
+ * room after a flush the frame is dropped. following is the room the frames
+ * queued right behind it take, the attachments of a binary packet, which go
+ * into the buffer together. Only a frame longer than the buffer, with what
+ * follows it, waits for the socket: it is begun on an empty buffer, unless
+ * the socket takes nothing, and written out in pieces as the buffer fills.
+ */
+bool SocketIOClientBase::beginFrame(wsOpcode_t opcode, size_t length, size_t following) {
+    if (!client->connected()) {
+        _droppedFrames++;
+        return false;
+    }
+    if (_maxPayload && length > _maxPayload && !(opcode & 0x08)) {
+        // the server would close the connection over it
+        DEBUG_WEBSOCKETS("message longer than the server's maxPayload dropped");
+        _droppedFrames++;
+        return false;
+    }
+    if (_txPieces) {
+        // the attachment of a packet sent in pieces, the server waits for it
+        if (_writer.space() < WS_MAX_HEADER_LEN && !drainTx()) return false;
+        return _writer.begin(opcode, length);
+    }
+    _txAborted = false;
+    if (_queuedFrames == 0) {
+        _queuedSince = millis();
+    }
+#ifdef SOCKETIO_DEFLATE
+    size_t room = 2 * length + WS_MAX_HEADER_LEN + following;
+    if (_deflateActive && _compression.threshold && length >= _compression.threshold &&
+        !(opcode & 0x08) && room <= _txLength) {
+        if (_writer.space() < room) {
+            flushTx();
+        }
+        if (_writer.space() >= room) {
+            _deflating = true;
+            _deflateOpcode = opcode;
+            _deflateLength = length;
+            _deflateFilled = 0;
+            return true;
+        }
+    }
+#endif
+    size_t needed = frameLength(length) + following;
+    if (needed > _txLength) {
+        // a socket that takes part of the buffer is waited for, not one that takes nothing
+        size_t queued = _writer.length();
+        if (!flushTx() && (_writer.length() == queued || !drainTx())) {
+            DEBUG_WEBSOCKETS("transmit buffer busy, frame longer than it dropped");
+            _droppedFrames++;
+            _drainWanted = true;
+            return false;
+        }
+        _txPieces = true;
+        return _writer.begin(opcode, length);
+    }
+    if (_writer.space() < needed) {
+        flushTx();
+    }
+    if (_writer.space() < needed) {
+        DEBUG_WEBSOCKETS("transmit buffer full, frame dropped");
+        _droppedFrames++;
+        _drainWanted = true;
+        return false;
+    }
+    return _writer.begin(opcode, length);
+}
+
+void SocketIOClientBase::appendFrame(const void *data, size_t length) {
+    if (_txAborted || length == 0) return;
+#ifdef SOCKETIO_DEFLATE
+    if (_deflating) {
+        // memmove, the typed emit() hands over a packet in the free space
+        memmove(&_txBuffer[_txLength - _deflateLength + _deflateFilled], data, length);
+        _deflateFilled += length;
+        return;
+    }
+#endif
+    // beginFrame() made room for all of it, unless the frame goes out in pieces
+    const uint8_t *p = (const uint8_t *)data;
+    while (true) {
+        size_t n = _writer.append(p, length);
+        p += n;
+        length -= n;
+        if (length == 0 || !drainTx()) return;
+    }
+}
+
+void SocketIOClientBase::endFrame(bool more) {
+    if (_txAborted) return;
+#ifdef SOCKETIO_DEFLATE
+    if (_deflating) {
+        _deflating = false;
+        deflateFrame();
+    }
+#endif
+    _queuedFrames++;
+    SOCKETIO_STAT(_stats.framesOut++;)
+    if (!more) {
+        _txPieces = false;
+    }
+    if (!more && flushDue()) {
+        flushTx();
+    }
+    if (!writable()) {
+        _drainWanted = true;
+    }
+}
+
+#ifdef SOCKETIO_DEFLATE
+void SocketIOClientBase::deflateFrame() {
+    // beginFrame() left room for the header and for output as long as the message
+    const uint8_t *message = &_txBuffer[_txLength - _deflateLength];
+    uint8_t *out = &_txBuffer[_writer.length() + WS_MAX_HEADER_LEN];
+    size_t length = _deflater.deflate(message, _deflateLength, out, _deflateLength - 1);
+    if (length) {
+        _writer.begin(_deflateOpcode, length, true);
+        _writer.append(out, length);
     } else {
-        messageBuffer[1] = 127 + 128;
-        messageBuffer[2] = (msglength >> 56) & 255;
-        messageBuffer[3] = (msglength >> 48) & 255;
-        messageBuffer[4] = (msglength >> 40) & 255;
-        messageBuffer[5] = (msglength >> 32) & 255;
-        messageBuffer[6] = (msglength >> 24) & 255;
-        messageBuffer[7] = (msglength >> 16) & 255;
-        messageBuffer[8] = (msglength >> 8) & 255;
-        messageBuffer[9] = (msglength)&255;
-        index = 10;
+        // it would not get any shorter
+        _writer.begin(_deflateOpcode, _deflateLength);
+        _writer.append(message, _deflateLength);
     }
+}
+#endif
+
+bool SocketIOClientBase::flushDue() const {
+    return (_flushPolicy.maxFrames && _queuedFrames >= _flushPolicy.maxFrames) ||
+        (_flushPolicy.maxBytes && _writer.length() >= _flushPolicy.maxBytes);
+}
 
-    randomSeed(analogRead(0));
-    for (int i = 0; i < 4; i++) {
-        messageBuffer[index] = random(48, 57);
-        index++;
+/// @return true if the socket took everything
+bool SocketIOClientBase::flushTx() {
+    _writer.seal();
+    _queuedFrames = 0;
+    if (_writer.length() == 0) return true;
+    size_t written = writeSocket(_writer.data(), _writer.length());
+    SOCKETIO_STAT(_stats.bytesOut += written;)
+    _writer.consume(written);
+    if (_writer.length()) {
+        DEBUG_WEBSOCKETS("short write, %u bytes left", (unsigned int)_writer.length());
+        return false;
     }
-    for (int i = 0; i < msglength; i++)
-        messageBuffer[i + index] = message[i] ^ messageBuffer[(index - 4) + (i % 4)];
+    return true;
+}
 
-    index += msglength;
-    client.write(messageBuffer, index);
+/// Waits for the socket to take everything, the connection is dropped if it does not
+bool SocketIOClientBase::drainTx() {
+    unsigned long start = millis();
+    while (!flushTx()) {
+        if (!client->connected() || millis() - start >= _timeouts.write) {
+            fail("write stalled");
+            _txAborted = true;
+            return false;
+        }
+        yield();
+    }
+    return true;
 }
 
-const unsigned int eParseTypeID = 0;
-const unsigned int eParseTypeEVENT = 1;
-const unsigned int eParseTypeDATA = 2;
+void SocketIOClientBase::discardTx() {
+    _droppedFrames += _queuedFrames;
+    _writer.clear();
+    _queuedFrames = 0;
+    _txPieces = false;
+}
 
-socketIOPacket_t SocketIOClient::parse(const std::string &payloadStr) {
-    socketIOPacket_t result;
-    unsigned int currentParseType = eParseTypeID;
-    bool escChar = false;
-    bool inString = false;
-    bool inJson = false;
-    bool inArray = false;
-    for (auto c : payloadStr) {
-        if (!escChar && c == '"') {
-            if (inString)
-                inString = false;
-            else
-                inString = true;
-            if (!inJson && !inArray)
-                continue;
+void SocketIOClientBase::setFlushPolicy(const socketIOFlushPolicy_t &policy) {
+    _flushPolicy = policy;
+    if (_queuedFrames && flushDue()) {
+        flushTx();
+    }
+}
+
+void SocketIOClientBase::flush() {
+    flushTx();
+}
+
+void SocketIOClientBase::onDrain(drainCallback_fn func) {
+    _drainCallback = func;
+}
+
+#ifdef SOCKETIO_STATS
+void SocketIOClientBase::recordTime(uint32_t *histogram, unsigned long duration) {
+    size_t bucket = 0;
+    while (duration > 1 && bucket < SOCKETIO_STATS_BUCKETS - 1) {
+        duration >>= 1;
+        bucket++;
+    }
+    histogram[bucket]++;
+}
+
+socketIOStats_t SocketIOClientBase::stats() const {
+    return _stats;
+}
+
+void SocketIOClientBase::resetStats() {
+    _stats = socketIOStats_t();
+    _pingPending = false;
+    for (size_t i = 0; i < _handlerCount; i++) {
+        _handlers[i].count = 0;
+    }
+}
+
+unsigned long SocketIOClientBase::eventCount(const char *event) const {
+    for (size_t i = 0; i < _handlerCount; i++) {
+        if (strcmp(_handlers[i].event, event) == 0) return _handlers[i].count;
+    }
+    return 0;
+}
+
+// appends to buffer like snprintf(), the returned length may exceed size
+static size_t appendJson(char *buffer, size_t size, size_t length, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(length < size ? &buffer[length] : NULL, length < size ? size - length : 0, format, args);
+    va_end(args);
+    return length + (n > 0 ? n : 0);
+}
+
+static size_t appendHistogram(char *buffer, size_t size, size_t length, const char *name, const uint32_t *histogram) {
+    size_t used = SOCKETIO_STATS_BUCKETS;
+    while (used && histogram[used - 1] == 0) used--;
+    length = appendJson(buffer, size, length, ",\"%s\":[", name);
+    for (size_t i = 0; i < used; i++) {
+        length = appendJson(buffer, size, length, i ? ",%lu" : "%lu", (unsigned long)histogram[i]);
+    }
+    return appendJson(buffer, size, length, "]");
+}
+
+size_t SocketIOClientBase::snapshotStats(char *buffer, size_t size) const {
+    size_t length = appendJson(buffer, size, 0, "{\"rtt\":[%lu,%lu,%lu,%lu],\"in\":[%lu,%lu],\"out\":[%lu,%lu],\"events\":{",
+        _stats.rttLast, _stats.rttMin, _stats.rttMax, _stats.rttAverage,
+        _stats.framesIn, _stats.bytesIn, _stats.framesOut, _stats.bytesOut);
+    unsigned long others = _stats.events;
+    for (size_t i = 0; i < _handlerCount; i++) {
+        length = appendJson(buffer, size, length, "\"%s\":%lu,", _handlers[i].event, _handlers[i].count);
+        others -= _handlers[i].count;
+    }
+    length = appendJson(buffer, size, length, "\"\":%lu},\"handshake\":%lu,\"connect\":[%lu,%lu],\"reconnects\":%lu,\"heap\":%lu",
+        others, _stats.handshakeTime, _stats.connectTime, _stats.transportConnects, _stats.reconnects, (unsigned long)_stats.heapLow);
+    length = appendHistogram(buffer, size, length, "parse", _stats.parseTime);
+    length = appendHistogram(buffer, size, length, "dispatch", _stats.dispatchTime);
+    return appendJson(buffer, size, length, "}");
+}
+#endif
+
+socketIOJsonCursor_t socketIOView_t::arg(size_t n) const {
+    socketIOJsonCursor_t value = json();
+    while (n-- && value.exists()) {
+        value = value.next();
+    }
+    return value;
+}
+
+socketIOView_t socketIOView_t::unquoted() const {
+    socketIOView_t inner = *this;
+    if (length >= 2 && ptr[0] == '"' && ptr[length - 1] == '"') {
+        inner.ptr++;
+        inner.length -= 2;
+    }
+    return inner;
+}
+
+uint32_t socketIOHash(const socketIOView_t &str) {
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < str.length; i++) {
+        hash = (hash ^ (uint8_t)str.ptr[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+String socketIOView_t::toString() const {
+    String str;
+    str.reserve(length);
+    str.concat(ptr, length);
+    return str;
+}
+
+static const char base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static size_t base64Encode(const uint8_t *data, size_t length, char *out) {
+    char *p = out;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t group = (uint32_t)data[i] << 16;
+        if (i + 1 < length) group |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) group |= data[i + 2];
+        *p++ = base64Chars[(group >> 18) & 63];
+        *p++ = base64Chars[(group >> 12) & 63];
+        *p++ = i + 1 < length ? base64Chars[(group >> 6) & 63] : '=';
+        *p++ = i + 2 < length ? base64Chars[group & 63] : '=';
+    }
+    return p - out;
+}
+
+static int base64Value(uint8_t c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+static bool base64Decode(const uint8_t *data, size_t length, uint8_t *out, size_t &outLength) {
+    // out may be data itself or lie before it, it is written behind the input read
+    if (length % 4) return false;
+    uint8_t *p = out;
+    for (size_t i = 0; i < length; i += 4) {
+        int padding = data[i + 3] == '=' ? (data[i + 2] == '=' ? 2 : 1) : 0;
+        if (padding && i + 4 != length) return false;
+        uint32_t group = 0;
+        for (int j = 0; j < 4; j++) {
+            int value = j < 4 - padding ? base64Value(data[i + j]) : 0;
+            if (value < 0) return false;
+            group = (group << 6) | value;
         }
-        if (c == '\\') {
-            if (escChar)
-                escChar = false;
-            else
-                escChar = true;
-        } else if (escChar)
-            escChar = false;
+        *p++ = group >> 16;
+        if (padding < 2) *p++ = group >> 8;
+        if (padding < 1) *p++ = group;
+    }
+    outLength = p - out;
+    return true;
+}
+
+static socketIOView_t trimmed(const char *begin, const char *end) {
+    while (begin < end && isspace(*begin)) begin++;
+    while (end > begin && isspace(end[-1])) end--;
+    socketIOView_t view;
+    view.ptr = begin;
+    view.length = end - begin;
+    return view;
+}
 
-        if (!inJson && !inString && c == '{')
-            inJson = true;
-        if (inJson && !inString && c == '}')
-            inJson = false;
+/**
+ * Splits the start of an event packet that is too long to be parse()d at
+ * once, [/namespace,][id]["event", up to its data.
+ * @param data set to the offset of the data in payload
+ */
+static bool parseHead(const char *payload, size_t length, socketIOPacketView_t &packet, size_t &data) {
+    const char *p = payload;
+    const char *end = payload + length;
+    packet = socketIOPacketView_t();
+    if (p < end && *p == '/') {
+        const char *nsp = p;
+        while (p < end && *p != ',') p++;
+        if (p == end) return false;
+        packet.nsp.ptr = nsp;
+        packet.nsp.length = p - nsp;
+        p++;
+    }
+    packet.id.ptr = p;
+    while (p < end && *p >= '0' && *p <= '9') p++;
+    packet.id.length = p - packet.id.ptr;
 
-        if (currentParseType > eParseTypeID)
-            if (!inArray && !inString && c == '[')
-                inArray = true;
+    if (p == end || *p != '[') return false;
+    p++;
+    while (p < end && isspace(*p)) p++;
+    if (p == end || *p != '"') return false;
+    const char *event = ++p;
+    bool escChar = false;
+    for (; p < end; p++) {
+        if (escChar)
+            escChar = false;
+        else if (*p == '\\')
+            escChar = true;
+        else if (*p == '"')
+            break;
+    }
+    if (p == end) return false;
+    packet.event.ptr = event;
+    packet.event.length = p - event;
+    p++;
+    while (p < end && isspace(*p)) p++;
+    if (p == end || *p != ',') return false;
+    data = p + 1 - payload;
+    return true;
+}
 
-        if (!inArray && !inString && !inJson && !escChar) {
-            if (c == '[' && currentParseType == eParseTypeID) {
-                currentParseType++;
-                continue;
-            }
-            if (c == ',' && currentParseType == eParseTypeEVENT) {
-                currentParseType++;
-                continue;
-            }
-            if (c == ']') {
-                break;
-            }
+bool SocketIOClientBase::parse(socketIOmessageType_t type, const char *payload, size_t length, socketIOPacketView_t &packet) {
+    const char *p = payload;
+    const char *end = payload + length;
+    packet = socketIOPacketView_t();
+    bool ack = type == sIOtype_ACK || type == sIOtype_BINARY_ACK;
+
+    if (type == sIOtype_BINARY_EVENT || type == sIOtype_BINARY_ACK) {
+        const char *count = p;
+        while (p < end && *p >= '0' && *p <= '9') {
+            packet.attachments = packet.attachments * 10 + (*p++ - '0');
         }
+        if (p == count || p == end || *p != '-') return false;
+        p++;
+    }
+
+    if (p < end && *p == '/') {
+        const char *nsp = p;
+        while (p < end && *p != ',') p++;
+        if (p == end) return false;
+        packet.nsp.ptr = nsp;
+        packet.nsp.length = p - nsp;
+        p++;
+    }
 
-        if (currentParseType > eParseTypeID)
-            if (inArray && !inString && c == ']')
-                inArray = false;
+    packet.id.ptr = p;
+    while (p < end && *p >= '0' && *p <= '9') p++;
+    packet.id.length = p - packet.id.ptr;
 
-        if (currentParseType == eParseTypeID) {
-            result.id += c;
-        } else if (currentParseType == eParseTypeEVENT) {
-            result.event += c;
-        } else if (currentParseType == eParseTypeDATA) {
-            result.data += c;
+    if (p == end || *p != '[') return false;
+    const char *element = ++p;
+    const char *data = NULL;
+    unsigned int depth = 1;
+    bool inString = false;
+    bool escChar = false;
+    for (; p < end; p++) {
+        char c = *p;
+        if (inString) {
+            if (escChar)
+                escChar = false;
+            else if (c == '\\')
+                escChar = true;
+            else if (c == '"')
+                inString = false;
+            continue;
+        }
+        if (c == '"') {
+            inString = true;
+        } else if (c == '[' || c == '{') {
+            depth++;
+        } else if (c == ']' || c == '}') {
+            if (--depth == 0) break;
+        } else if (c == ',' && depth == 1 && !data && !ack) {
+            packet.event = trimmed(element, p);
+            data = p + 1;
         }
     }
+    if (p == end) return false;
+
+    if (ack) {
+        packet.data = trimmed(element, p);
+        return true;
+    }
+    if (data) {
+        packet.data = trimmed(data, p);
+    } else {
+        packet.event = trimmed(element, p);
+    }
+    // the event name has to be a JSON string
+    if (packet.event.length < 2 || packet.event.ptr[0] != '"' || packet.event.ptr[packet.event.length - 1] != '"') return false;
+    packet.event = packet.event.unquoted();
+    return true;
+}
+
+socketIOPacket_t SocketIOClientBase::parse(const std::string &payloadStr) {
+    socketIOPacket_t result;
+    socketIOPacketView_t packet;
+    if (parse(sIOtype_EVENT, payloadStr.c_str(), payloadStr.length(), packet)) {
+        result.id = packet.id.toString();
+        result.event = packet.event.toString();
+        result.data = packet.data.unquoted().toString();
+    }
     return result;
 }
@@ -26,7 +26,12 @@ OTHER DEALINGS IN THE SOFTWARE.
 #define _SOCKET_IO_CLIENT_H
 
 #include <Arduino.h>
-#include <map>
+#include <functional>
+#include <string>
+#include <SocketIOFrame.h>
+#include <SocketIODeflate.h>
+#include <SocketIOJson.h>
+#include <SocketIOCapture.h>
 
 #if defined(W5100)
 #include <Ethernet.h>
@@ -36,9 +41,12 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include "SPI.h"					//For ENC28J60
 #elif defined(ESP8266)
 #include <ESP8266WiFi.h>				//For ESP8266
+#include <WiFiClientSecure.h>				//For ESP8266
 #elif defined(ESP32)
 #include <WiFi.h>					//For ESP32
 #include <WiFiClientSecure.h>					//For ESP32
+#elif defined(SOCKETIO_HOST)
+#include <PosixClient.h>				//For Linux host builds, see extras/host
 #elif (!defined(ESP32) && !defined(ESP8266) && !defined(W5100) && !defined(ENC28J60))	//If no interface is defined
 #error "Please specify an interface such as W5100, ENC28J60, ESP8266 or ESP32"
 #error "above your includes like so : #define ESP8266 "
@@ -55,8 +63,58 @@ OTHER DEALINGS IN THE SOFTWARE.
 #endif
 #endif
 
-// Length of static data buffers
+// Build with SOCKETIO_STATS defined to keep the counters of socketIOStats_t,
+// without it they and their upkeep are compiled out
+#ifdef SOCKETIO_STATS
+#define SOCKETIO_STAT(...) __VA_ARGS__
+#else
+#define SOCKETIO_STAT(...)
+#endif
+// Buckets of the time histograms: bucket n counts durations of 2^n to
+// 2^(n+1)-1 us, bucket 0 those under 2 us, the last one all longer ones
+#ifndef SOCKETIO_STATS_BUCKETS
+#define SOCKETIO_STATS_BUCKETS 16
+#endif
+
+// Length of the receive and transmit buffers of SocketIOClient, see SocketIOClientT for others
+#ifndef DATA_BUFFER_LEN
 #define DATA_BUFFER_LEN 512
+#endif
+#ifndef TX_BUFFER_LEN
+#define TX_BUFFER_LEN 512
+#endif
+// Number of handlers on() of SocketIOClient can register
+#ifndef SOCKETIO_MAX_HANDLERS
+#define SOCKETIO_MAX_HANDLERS 16
+#endif
+// Number of namespaces sharing the connection, the default one "/" included
+#ifndef SOCKETIO_MAX_NAMESPACES
+#define SOCKETIO_MAX_NAMESPACES 4
+#endif
+// Number of acks emit() of SocketIOClient can wait for at the same time
+#ifndef SOCKETIO_MAX_ACKS
+#define SOCKETIO_MAX_ACKS 8
+#endif
+// Bytes kept of the events emitted while offline, replayed once connected. 0 disables it
+#ifndef SOCKETIO_OFFLINE_BUFFER_LEN
+#define SOCKETIO_OFFLINE_BUFFER_LEN 0
+#endif
+// Number of events emitLatest() keeps the latest value of, 0 disables it
+#ifndef SOCKETIO_LATEST_SLOTS
+#define SOCKETIO_LATEST_SLOTS 0
+#endif
+// Bytes of a slot of emitLatest(): key, event and content with their terminators
+#ifndef SOCKETIO_LATEST_LEN
+#define SOCKETIO_LATEST_LEN 128
+#endif
+// Bytes of the ring recording what the connection read and wrote, a power of two, 0 for none
+#ifndef SOCKETIO_CAPTURE_LEN
+#define SOCKETIO_CAPTURE_LEN 0
+#endif
+// Number of binary attachments a received event or ack may carry
+#ifndef SOCKETIO_MAX_ATTACHMENTS
+#define SOCKETIO_MAX_ATTACHMENTS 4
+#endif
 
 struct socketIOPacket_t {
     String id = "";
@@ -64,6 +122,55 @@ struct socketIOPacket_t {
     String data = "";
 };
 
+/**
+ * A view (pointer and length) into a received message, not null terminated.
+ * Views are only valid while the callback they are handed to runs.
+ */
+struct socketIOView_t {
+    const char *ptr = NULL;
+    size_t length = 0;
+
+    socketIOView_t() {}
+    socketIOView_t(const char *str) : ptr(str), length(str ? strlen(str) : 0) {}
+    socketIOView_t(const char *str, size_t len) : ptr(str), length(len) {}
+
+    bool empty() const { return length == 0; }
+    bool equals(const char *str) const { return (length == 0 || strncmp(ptr, str, length) == 0) && str[length] == 0; }
+    /// The inside of a JSON string value, or the view itself if it is not a string
+    socketIOView_t unquoted() const;
+    String toString() const;
+    /// The JSON of the first argument of an event, the ones after it follow with next()
+    socketIOJsonCursor_t json() const { return socketIOJsonCursor_t(ptr, length); }
+    /// The JSON of the n-th argument
+    socketIOJsonCursor_t arg(size_t n) const;
+};
+
+/**
+ * Packet descriptor produced by SocketIOClient::parse(), all fields are views
+ * into the parsed payload: [/namespace,][id][EVENT,DATA] for events and
+ * [/namespace,][id][DATA] for acks. The event view excludes its quotes, the
+ * data view is the raw JSON of the remaining arguments.
+ * Binary events and acks start with their number of attachments, N-.
+ */
+struct socketIOPacketView_t {
+    socketIOView_t nsp;
+    socketIOView_t id;
+    socketIOView_t event;
+    socketIOView_t data;
+    size_t attachments = 0;
+};
+
+/**
+ * Binary attachments of an event or ack, in the order of the placeholders
+ * {"_placeholder":true,"num":N} standing for them in the data. They point
+ * into the receive buffer and are only valid while the callback runs.
+ */
+struct socketIOAttachments_t {
+    size_t count = 0;
+    const uint8_t *data[SOCKETIO_MAX_ATTACHMENTS];
+    size_t length[SOCKETIO_MAX_ATTACHMENTS];
+};
+
 typedef enum : char {
     eIOtype_OPEN = '0', ///< Sent from the server when a new transport is opened (recheck)
     eIOtype_CLOSE = '1', ///< Request the close of this transport but does not shutdown the connection itself.
@@ -84,65 +191,816 @@ typedef enum : char {
     sIOtype_BINARY_ACK = '6',
 } socketIOmessageType_t;
 
+/**
+ * When the queued outgoing frames are written to the socket. Frames are
+ * flushed by emit() as soon as maxBytes or maxFrames is reached (0: no limit),
+ * and by loop() once the oldest frame waited maxDelay ms (0: the next loop()).
+ * The defaults send every frame right away.
+ * What the socket does not take stays queued and loop() writes it later.
+ * writable() is false from highWater bytes waiting on (0: half the transmit
+ * buffer), onDrain() tells when it is true again.
+ */
+struct socketIOFlushPolicy_t {
+    size_t maxBytes = 0;
+    size_t maxFrames = 1;
+    unsigned long maxDelay = 0;
+    size_t highWater = 0;
+};
+
+typedef enum : uint8_t {
+    sIOstate_DISCONNECTED,
+    sIOstate_CONNECTING, ///< About to open the TCP connection, the only step that may block
+    sIOstate_POLLING,    ///< Waiting for the long-polling handshake response (session id, ping interval)
+    sIOstate_UPGRADING,  ///< Waiting for the WebSocket upgrade response
+    sIOstate_PROBING,    ///< WebSocket open, waiting for the answer to the "2probe" ping
+    sIOstate_CONNECTED,
+    sIOstate_OPENING,    ///< WebSocket opened directly, waiting for the engine.io open packet
+} socketIOState_t;
+
+/**
+ * What carries the connection, chosen with begin() or connect(). TLS is
+ * WiFiClientSecure on ESP8266 and ESP32, checked against root_ca if given,
+ * not checked at all otherwise. Other interfaces only have PLAIN, unless
+ * setClient() hands the client a secure transport.
+ */
+typedef enum : uint8_t {
+    sIOtransport_PLAIN,
+    sIOtransport_TLS,
+} socketIOTransport_t;
+
+/**
+ * How a connection is set up. POLLING does the long-polling handshake for
+ * the session id and ping interval on a first connection, then upgrades a
+ * second one to WebSocket and probes it. WEBSOCKET opens the WebSocket
+ * right away and reads them from its first frame: one connection (and TLS
+ * handshake) and one round trip less. If the server refuses the WebSocket
+ * without a session, the client falls back to POLLING until the next
+ * connect() or setConnectMode().
+ */
+typedef enum : uint8_t {
+    sIOconnect_POLLING,
+    sIOconnect_WEBSOCKET,
+} socketIOConnectMode_t;
+
+/**
+ * The engine.io protocol the server speaks, asked for with EIO= in the
+ * requests. With EIO3 (Socket.IO 2 servers) the client pings every
+ * pingInterval ms and the server answers. With EIO4 (Socket.IO 3 and 4)
+ * the server pings and the client answers, the client joins the default
+ * namespace itself and binary attachments go without their engine.io type.
+ * In both a connection that brings nothing for pingInterval + pingTimeout
+ * ms, as the open packet tells them, is dropped as dead.
+ */
+typedef enum : uint8_t {
+    sIOprotocol_EIO3,
+    sIOprotocol_EIO4,
+} socketIOProtocol_t;
+
+/**
+ * How binary attachments travel over the WebSocket, requested from the server
+ * with the b64 query parameter when connecting. NATIVE uses binary frames,
+ * BASE64 asks for base64 text frames instead, for servers and proxies that
+ * do not pass binary frames. Either form is understood when received, and
+ * once the server sends base64 the client answers in base64 as well.
+ */
+typedef enum : uint8_t {
+    sIObinary_NATIVE,
+    sIObinary_BASE64,
+} socketIOBinaryMode_t;
+
+/**
+ * When loop() connects again after the connection failed or was lost. The
+ * n-th attempt in a row waits initialDelay * factor^(n-1) ms, at most
+ * maxDelay, shortened by a random part of up to jitter percent so clients
+ * dropped together do not come back together. After maxAttempts failed
+ * attempts (0: no limit), or with enabled false, only connect() reconnects.
+ */
+struct socketIOReconnectPolicy_t {
+    bool enabled = true;
+    unsigned long initialDelay = 1000;
+    unsigned long maxDelay = 30000;
+    uint8_t factor = 2;
+    uint8_t jitter = 50;
+    unsigned int maxAttempts = 0;
+};
+
+/**
+ * Acks emit() waits for, as many as the ack table holds. The callback of
+ * an ack that is not answered within timeout ms (0: no limit), or before the
+ * connection is lost, is called with a NULL payload. When all slots are
+ * taken emit() rejects the event, or gives up on the oldest pending ack.
+ */
+struct socketIOAckPolicy_t {
+    unsigned long timeout = 10000;
+    bool evictOldest = false;
+};
+
+#ifdef SOCKETIO_STATS
+/**
+ * Where the time and the traffic go, see SOCKETIO_STATS. Ping round trips
+ * are in us, the average weighs the latest one 1/8. Frames and bytes are
+ * those of the WebSocket connection, without the HTTP handshake.
+ */
+struct socketIOStats_t {
+    unsigned long rttLast = 0;
+    unsigned long rttMin = 0;
+    unsigned long rttMax = 0;
+    unsigned long rttAverage = 0;
+    unsigned long framesIn = 0;
+    unsigned long bytesIn = 0;
+    unsigned long framesOut = 0;
+    unsigned long bytesOut = 0;
+    /// Events received, dispatched or not, see SocketIOClient::eventCount()
+    unsigned long events = 0;
+    /// ms from starting to connect to connected, for the last connection
+    unsigned long handshakeTime = 0;
+    /// us the transport's connect() took for the last connection, TLS handshakes included
+    unsigned long connectTime = 0;
+    /// Connections the transport opened, one or two per connection attempt
+    unsigned long transportConnects = 0;
+    unsigned long reconnects = 0;
+    /// Least free heap loop() saw, 0 where it cannot be known
+    size_t heapLow = 0;
+    /// Time spent in parse() and in the handlers of events and acks
+    uint32_t parseTime[SOCKETIO_STATS_BUCKETS] = {};
+    uint32_t dispatchTime[SOCKETIO_STATS_BUCKETS] = {};
+};
+#endif
+
+#ifdef SOCKETIO_DEFLATE
+/**
+ * permessage-deflate use, for builds with SOCKETIO_DEFLATE. Outgoing text
+ * and binary messages from threshold bytes on (0: none) are compressed if
+ * the result is shorter and the message fits twice in the transmit buffer.
+ * Compressed messages received are always inflated.
+ */
+struct socketIOCompression_t {
+    bool offer = true;       ///< Offer the extension when connecting
+    size_t threshold = 128;
+};
+#endif
+
+/// Longest time in ms each handshake phase may take before the attempt is dropped
+struct socketIOTimeouts_t {
+    unsigned long polling = 10000;
+    unsigned long upgrade = 10000;
+    /// for the answer to the probe, or for the open packet of a direct WebSocket
+    unsigned long probe = 5000;
+    /// how long the socket may refuse the rest of a frame longer than the transmit buffer
+    unsigned long write = 5000;
+};
+
+/// FNV-1a, usable in constant expressions so event names can be hashed at compile time
+constexpr uint32_t socketIOHash(const char *str, uint32_t hash = 2166136261UL) {
+    return *str ? socketIOHash(str + 1, (hash ^ (uint8_t)*str) * 16777619UL) : hash;
+}
+uint32_t socketIOHash(const socketIOView_t &str);
+
+class SocketIOClientBase;
+
+/**
+ * Answers the event it is handed with, if the sender asked for an ack.
+ * Nothing is built until it is called, and it refers to the received
+ * packet, so it may only be called while the handler runs.
+ */
+class socketIOAck_t {
+public:
+    socketIOAck_t(SocketIOClientBase *client, const socketIOPacketView_t *packet) : _client(client), _packet(packet) {}
+    bool requested() const { return !_packet->id.empty(); }
+    void operator()(const char *payload) const;
+    /// Answers with a single binary attachment
+    void operator()(const uint8_t *data, size_t length) const;
+private:
+    SocketIOClientBase *_client;
+    const socketIOPacketView_t *_packet;
+};
+
+typedef std::function<void (socketIOState_t state)> stateCallback_fn;
 typedef std::function<void (const char * payload)> ackCallback_fn;
+typedef std::function<void ()> drainCallback_fn;
 typedef std::function<void (const String &payload, ackCallback_fn)> callback_fn;
+typedef std::function<void (const socketIOView_t &payload, const socketIOAck_t &ack)> viewCallback_fn;
+typedef std::function<void (const socketIOView_t &payload, const socketIOAttachments_t &attachments, const socketIOAck_t &ack)> binaryCallback_fn;
+typedef std::function<void (const socketIOView_t &payload, const socketIOAttachments_t &attachments)> binaryAckCallback_fn;
+
+typedef enum : uint8_t {
+    sIOstream_BEGIN, ///< An event starts, no data yet
+    sIOstream_DATA,  ///< The next piece of its data
+    sIOstream_END,   ///< All of its data was delivered
+    sIOstream_ABORT, ///< The event is malformed or the connection was lost, the data delivered so far is incomplete
+} socketIOStreamPhase_t;
+/**
+ * Receives the data of an event, the raw JSON of its arguments as for
+ * viewCallback_fn, in pieces as its frames arrive. Events longer than the
+ * receive buffer come in pieces of up to its length - 1 bytes, shorter
+ * ones in one piece. The pieces are only valid during the call.
+ */
+typedef std::function<void (socketIOStreamPhase_t phase, const char *data, size_t length)> streamCallback_fn;
+typedef void (*eventHandler_fn)(const socketIOView_t &payload, const socketIOAck_t &ack);
+
+/**
+ * Entry of a handler table fixed at compile time, see SocketIOClient::setHandlers().
+ * static const socketIOHandler_t handlers[] = {
+ *     SOCKETIO_HANDLER("rtime", onTime),
+ * };
+ */
+struct socketIOHandler_t {
+    uint32_t hash;
+    const char *event;
+    eventHandler_fn handler;
+};
+#define SOCKETIO_HANDLER(event, handler) { socketIOHash(event), event, handler }
 
-class SocketIOClient {
+/**
+ * A namespace multiplexed over the connection of its SocketIOClient, see
+ * SocketIOClient::of(). It has handlers of its own, "connect", "disconnect"
+ * and "connect_error" included, and shares the transport, the buffers, the
+ * ack table and the ping timer with the other namespaces. It is joined once
+ * the connection is up, and again after every reconnect, until leave().
+ * Emits while it is not connected are dropped, they are not held offline.
+ */
+class SocketIONamespace {
 public:
+	const char *name() const { return _name; }
+	/// The server accepted the namespace on the current connection
+	bool connected() const { return _connected; }
+	/// Joins the namespace again after leave()
+	void join();
+	/// Leaves the namespace, acks still pending are called with NULL
+	void leave();
+
+	bool emit(const char *event, const char *content, ackCallback_fn = NULL);
+	template <typename... Args>
+	bool emitArgs(const char *event, const Args &... args);
+	template <typename... Args>
+	bool emitArgs(const socketIOEvent_t &event, const Args &... args);
+	bool emitBinary(const char *event, const uint8_t *data, size_t length, binaryAckCallback_fn = NULL);
+
+	bool on(const char* event, callback_fn);
+	bool on(const char* event, viewCallback_fn);
+	bool on(const char* event, binaryCallback_fn);
+	bool on(const char* event, streamCallback_fn);
+
+private:
+	friend class SocketIOClientBase;
+	SocketIONamespace() {}
+	SocketIOClientBase *_client = NULL;
+	const char *_name = NULL;
+	uint8_t _index = 0;
+	bool _joined = false;
+	bool _connected = false;
+};
+
+/**
+ * The client, over buffers and tables it is given by SocketIOClientT, which
+ * holds them. Nothing is allocated by the client itself: events, acks and
+ * emits are handled in that storage, only the String handlers of on() and
+ * std::function callbacks too large for their inline storage use the heap.
+ */
+class SocketIOClientBase {
+public:
+	SocketIOClientBase(const SocketIOClientBase &) = delete;
+	SocketIOClientBase &operator=(const SocketIOClientBase &) = delete;
+	/// TLS if root_ca is given, PLAIN otherwise
 	void begin(const char* host, unsigned int port, const char* root_ca = NULL);
+	/// Takes effect with the next connection, loop() connects when disconnected
+	void begin(const char* host, unsigned int port, socketIOTransport_t transport, const char* root_ca = NULL);
+	/**
+	 * Replaces the transport the connection runs over, e.g. a GSM modem client.
+	 * Defaults to the client of the interface selected with W5100, ENC28J60,
+	 * ESP8266 or ESP32. The transport has to outlive the SocketIOClient.
+	 */
+	void setClient(Client &transport);
 	bool connect(const char* host, unsigned int port, const char* root_ca = NULL);
+	bool connect(const char* host, unsigned int port, socketIOTransport_t transport, const char* root_ca = NULL);
 	bool connected();
 	void disconnect();
 	void loop();
-	void emit(const char *event, const char *content, ackCallback_fn = NULL);
+	/**
+	 * Without a connection, events without an ack callback are held in the
+	 * offline buffer if SOCKETIO_OFFLINE_BUFFER_LEN is set.
+	 * @param ackCallback_fn called with the ack's arguments, or NULL if none came, see socketIOAckPolicy_t
+	 * An event longer than the transmit buffer is written out in pieces as
+	 * the buffer fills, waiting for the socket up to socketIOTimeouts_t::write.
+	 * @return false if the event was neither sent nor held: no connection, no
+	 * free ack slot, or no room in the transmit buffer even after a flush
+	 */
+	bool emit(const char *event, const char *content, ackCallback_fn = NULL);
+	/**
+	 * Sends the arguments as JSON, serialized straight into the transmit
+	 * buffer through socketIOJson: numbers, bools, C strings and String
+	 * (escaped), socketIORawJson_t and specializations for your own types.
+	 * Named apart from emit(), where a lone int could not be told from NULL
+	 * on targets that define NULL as one: emitArgs(event, count) sends it.
+	 * The packet has to fit the transmit buffer, it cannot be acked.
+	 * @return false if the event was neither sent nor held, as emit() above
+	 */
+	template <typename... Args>
+	bool emitArgs(const char *event, const Args &... args) {
+		return emitTyped(0, event, args...);
+	}
+	/// As above, with the packet prefix built at compile time, see SOCKETIO_EVENT()
+	template <typename... Args>
+	bool emitArgs(const socketIOEvent_t &event, const Args &... args) {
+		return emitTyped(0, event, args...);
+	}
+#if SOCKETIO_LATEST_SLOTS
+	/**
+	 * Emits the latest value of a telemetry-like event: the key (the event
+	 * name if NULL) holds one slot, and a value that was not sent yet is
+	 * replaced by the next one instead of queued behind it. A value goes out
+	 * once the client is connected, writable() and minInterval ms passed
+	 * since the key's last one, from here or from loop(). Values wait for a
+	 * connection, acks are not possible. Key and event are copied.
+	 * @return false if the key has no slot and none is free, or the key,
+	 * event and content do not fit SOCKETIO_LATEST_LEN
+	 */
+	bool emitLatest(const char *event, const char *content, unsigned long minInterval = 0, const char *key = NULL);
+	/// Values replaced before they were sent, of a key or of all of them
+	unsigned long supersededEvents(const char *key = NULL) const;
+	/// Gives the slot of the key back, dropping its value if it was not sent
+	void forgetLatest(const char *key);
+#endif
 	void send(const char *content);
-	void on(const char* event, callback_fn);
+	/**
+	 * Emits raw bytes as a binary event, a Buffer on the server side, without
+	 * JSON escaping and, unless sIObinary_BASE64 is in use, without base64.
+	 * The data is copied into the transmit buffer before emitBinary() returns.
+	 */
+	bool emitBinary(const char *event, const uint8_t *data, size_t length, binaryAckCallback_fn = NULL);
+	/// Takes effect with the next connection
+	void setBinaryMode(socketIOBinaryMode_t mode);
+	/// Takes effect with the next connection
+	void setConnectMode(socketIOConnectMode_t mode);
+	/// The mode the last connection was set up with, POLLING after a fallback
+	socketIOConnectMode_t connectMode() const { return _directRefused ? sIOconnect_POLLING : _connectMode; }
+	/// Takes effect with the next connection
+	void setProtocol(socketIOProtocol_t protocol) { _protocol = protocol; }
+	socketIOProtocol_t protocol() const { return _protocol; }
+	/// Heartbeat of the session, in ms, from the server's open packet
+	unsigned long pingInterval() const { return _pingInterval; }
+	unsigned long pingTimeout() const { return _pingTimeout; }
+	/// Longest message the server takes, from the open packet, 0 if it did not tell
+	size_t maxPayload() const { return _maxPayload; }
+	/**
+	 * Registers the handler of an event, replacing the previous one of any
+	 * kind. The name is not copied and has to stay valid, a string literal usually.
+	 * @return false if the handler table is full
+	 */
+	bool on(const char* event, callback_fn);
+	bool on(const char* event, viewCallback_fn);
+	/// Also receives the attachments of binary events, none for text events
+	bool on(const char* event, binaryCallback_fn);
+	/**
+	 * Streams the data of the event, however long it is. Compressed messages
+	 * longer than the receive buffer cannot be streamed and are dropped, events
+	 * streamed this way cannot be acked.
+	 */
+	bool on(const char* event, streamCallback_fn);
+	/// Adds a constant table of handlers, looked up after the ones given to on()
+	void setHandlers(const socketIOHandler_t *handlers, size_t count);
+	/// Removes the handlers of all namespaces
 	void clear();
+	/**
+	 * The namespace of that name, joined over this connection, e.g.
+	 * of("/telemetry"). on() and emit() of the client itself are those of
+	 * the default namespace, of("/"). The name is not copied.
+	 * @return NULL if SOCKETIO_MAX_NAMESPACES namespaces are in use already
+	 */
+	SocketIONamespace *of(const char *nsp);
+
+	socketIOState_t state() const { return _state; }
+	void onStateChange(stateCallback_fn);
+	void setTimeouts(const socketIOTimeouts_t &timeouts);
+	void setAckPolicy(const socketIOAckPolicy_t &policy);
+	void setReconnectPolicy(const socketIOReconnectPolicy_t &policy);
+	/// us from opening the last connection to CONNECTED, 0 until a connection got there
+	unsigned long handshakeTime() const { return _handshakeTime; }
+	/// Connection attempts loop() made after a failure, since the start
+	unsigned long reconnectAttempts() const { return _reconnectAttempts; }
+	/**
+	 * Events emit() holds while offline, and those it dropped because they did
+	 * not fit the SOCKETIO_OFFLINE_BUFFER_LEN buffer, the oldest ones first
+	 */
+	size_t bufferedEvents() const { return _offlineCount; }
+	unsigned long droppedEvents() const { return _droppedEvents; }
+#ifdef SOCKETIO_STATS
+	socketIOStats_t stats() const;
+	void resetStats();
+	/// Events received for a handler given to on()
+	unsigned long eventCount(const char *event) const;
+	/**
+	 * Writes the stats as JSON, ready to be emitted: {"rtt":[last,min,max,average],
+	 * "in":[frames,bytes],"out":[frames,bytes],"events":{"name":count,...,"":others},
+	 * "handshake":ms,"connect":[us,connections],"reconnects":n,"heap":bytes,"parse":[histogram],"dispatch":[histogram]}
+	 * with the histograms' trailing empty buckets left out.
+	 * @return the length written, as snprintf()
+	 */
+	size_t snapshotStats(char *buffer, size_t size) const;
+#endif
+	/// Acks emit() is waiting for
+	size_t pendingAcks() const { return _ackCount; }
+#if SOCKETIO_CAPTURE_LEN
+	/**
+	 * Writes what the connections read and wrote lately, to replay it with
+	 * extras/host's socketio_replay, to Serial in hex or to a file, see
+	 * SocketIOCapture. Recording goes on, unless paused with setCapture(false).
+	 * @return the bytes written
+	 */
+	size_t dumpCapture(Print &out, bool hex = false) const { return _capture.dump(out, hex); }
+	void setCapture(bool enabled) { _capturing = enabled; }
+	void clearCapture() { _capture.clear(); }
+	/// Bytes the capture holds, records included
+	size_t capturedBytes() const { return _capture.length(); }
+#endif
+#ifdef SOCKETIO_DEFLATE
+	/// The offer takes effect with the next connection, the threshold right away
+	void setCompression(const socketIOCompression_t &compression);
+	/// permessage-deflate was negotiated for the current connection
+	bool compressing() const { return _deflateActive; }
+#endif
+
+	void setFlushPolicy(const socketIOFlushPolicy_t &policy);
+	void flush();
+	/// Frames and bytes waiting in the transmit buffer, bytes include those the socket has not taken yet
+	size_t queuedFrames() const { return _queuedFrames; }
+	size_t queuedBytes() const { return _writer.length(); }
+	/// Frames discarded because there was no connection to write them to, or no room to queue them
+	unsigned long droppedFrames() const { return _droppedFrames; }
+	/// Fewer than the flush policy's highWater bytes wait to be sent
+	bool writable() const { return _writer.length() < (_flushPolicy.highWater ? _flushPolicy.highWater : _txLength / 2); }
+	/// Called by loop() once writable() is true again after it was false or a frame was dropped
+	void onDrain(drainCallback_fn func);
+
+	/**
+	 * Validates and splits a Socket.IO packet in a single pass without copying.
+	 * @param type sIOtype_EVENT, sIOtype_ACK or their binary variants, selects the layout described at socketIOPacketView_t
+	 * @param payload the packet following its type character
+	 * @return false if the packet is malformed
+	 */
+	static bool parse(socketIOmessageType_t type, const char *payload, size_t length, socketIOPacketView_t &packet);
+protected:
+	struct handler_t {
+		uint32_t hash;
+		uint8_t nsp;
+		const char *event;
+		callback_fn callback;
+		viewCallback_fn viewCallback;
+		binaryCallback_fn binaryCallback;
+		streamCallback_fn streamCallback;
+		SOCKETIO_STAT(unsigned long count = 0;)
+	};
+	struct ack_t {
+		uint32_t id = 0;
+		uint8_t nsp = 0;
+		unsigned long since = 0;
+		ackCallback_fn callback;
+		binaryAckCallback_fn binaryCallback;
+	};
+	SocketIOClientBase(char *rxBuffer, size_t rxLength, uint8_t *txBuffer, size_t txLength,
+		handler_t *handlers, size_t maxHandlers, ack_t *acks, size_t maxAcks);
+
 private:
-	void parser(int index);
+	void parser(const char *payload, size_t length);
 #if defined(W5100) || defined(ENC28J60)
-	EthernetClient client;				//For ENC28J60 or W5100
+	EthernetClient _defaultClient;				//For ENC28J60 or W5100
+#elif defined(ESP8266) || defined(ESP32)
+	WiFiClient _defaultClient;				//For ESP8266 or ESP32
+	WiFiClientSecure _secureClient;
+#if defined(ESP8266)
+	// BearSSL fills the session in on every handshake and resumes it on the next one
+	BearSSL::Session _tlsSession;
+	BearSSL::X509List _trustAnchors;
+	bool _trustAnchorsStale = true;
+#endif
+#elif defined(SOCKETIO_HOST)
+	PosixClient _defaultClient;
 #endif
-#if defined(ESP8266) || defined(ESP32)
-	WiFiClientSecure client;				//For ESP8266 or ESP32
+	Client *client = &_defaultClient;
+	socketIOTransport_t _transport = sIOtransport_PLAIN;
+	// the transport given to setClient() is used whatever begin() asked for
+	bool _customClient = false;
+	bool selectTransport();
+	bool openTransport();
+
+	socketIOState_t _state = sIOstate_DISCONNECTED;
+	unsigned long _stateSince = 0;
+	socketIOTimeouts_t _timeouts;
+	stateCallback_fn _stateCallback;
+	void setState(socketIOState_t state);
+	void sessionOpened();
+	void fail(const char *reason);
+	bool timedOut(unsigned long timeout);
+	void connectStep();
+	void requestPolling();
+	void requestUpgrade(bool open);
+	void upgradeOnNewConnection();
+
+	// WEBSOCKET connections go without the polling handshake, unless the server refused one
+	socketIOConnectMode_t _connectMode = sIOconnect_POLLING;
+	bool _directRefused = false;
+	// The upgrade request follows the polling response over the same connection
+	// if the server keeps it open, unless it dropped such a connection before
+	bool _httpClose;
+	bool _upgradeReused = false;
+	bool _reuseRefused = false;
+	// The polling response had the 40 of the default namespace in it
+	bool _pollingConnect = false;
+	unsigned long _handshakeStart = 0;
+	unsigned long _handshakeTime = 0;
+
+	// loop() connects again once _reconnectDelay ms passed since _reconnectFrom
+	socketIOReconnectPolicy_t _reconnectPolicy;
+	bool _reconnecting = false;
+	unsigned long _reconnectFrom = 0;
+	unsigned long _reconnectDelay = 0;
+	unsigned int _retries = 0;
+	unsigned long _reconnectAttempts = 0;
+	void scheduleReconnect();
+
+#ifdef SOCKETIO_STATS
+	socketIOStats_t _stats;
+	unsigned long _pingSent = 0;
+	bool _pingPending = false;
+	void recordTime(uint32_t *histogram, unsigned long duration);
+#endif
+
+	// Events emitted without a connection, records of a 2 byte length, a flag
+	// telling whether a payload follows (1) or the event is a whole serialized
+	// packet (2), the event and the payload with their terminators.
+	// replayOffline() sends them after the connect packet
+	size_t _offlineCount = 0;
+	unsigned long _droppedEvents = 0;
+#if SOCKETIO_OFFLINE_BUFFER_LEN
+	uint8_t _offline[SOCKETIO_OFFLINE_BUFFER_LEN];
+	size_t _offlineHead = 0;
+	size_t _offlineLength = 0;
+	bool _replay = false;
+	bool bufferOffline(const char *event, const char *content, bool packet = false);
+	void putOffline(const void *data, size_t length);
+	size_t offlineRecordLength() const;
+	void dropOffline();
+	void replayOffline();
+#endif
+
+#if SOCKETIO_LATEST_SLOTS
+	// Slots of emitLatest(), data holds the key, event and content with
+	// their terminators. The first value of a key goes out right away
+	struct latest_t {
+		uint32_t hash;
+		bool used = false;
+		bool pending = false;
+		bool hasContent;
+		uint16_t event;
+		uint16_t content;
+		unsigned long minInterval;
+		unsigned long sentAt;
+		unsigned long superseded;
+		char data[SOCKETIO_LATEST_LEN];
+	};
+	static_assert(SOCKETIO_LATEST_LEN <= 0xFFFF, "slot offsets are 16 bit");
+	latest_t _latest[SOCKETIO_LATEST_SLOTS];
+	bool _latestPending = false;
+	unsigned long _supersededEvents = 0;
+	latest_t *findLatest(const char *key);
+	void sendLatest();
 #endif
 
-	bool doHandshake();
-	void readLine();
+#if SOCKETIO_CAPTURE_LEN
+	SocketIOCapture<SOCKETIO_CAPTURE_LEN> _capture;
+	bool _capturing = true;
+	// reads of one pass share the time in *now, taken by the first of them
+	void capture(socketIOCaptureType_t type, const void *data = NULL, size_t length = 0, unsigned long *now = NULL) {
+		if (!_capturing) return;
+		unsigned long time = now && *now ? *now : micros();
+		if (now) *now = time;
+		_capture.record(type, time, data, length);
+	}
+#else
+	void capture(socketIOCaptureType_t, const void * = NULL, size_t = 0, unsigned long * = NULL) {}
+#endif
+	int readSocket(uint8_t *buffer, size_t size, bool messageStart = false, unsigned long *now = NULL);
+	size_t writeSocket(const uint8_t *data, size_t length);
+
+	int _httpStatus;
+	size_t _httpLength;
+	long _contentLength;
+	bool _inBody;
+	void beginHttpResponse();
+	bool readHttpResponse();
+	void handleHttpHeader(const char *line);
+	bool parseOpenPacket(const char *packet);
+	char _sid[32];
+
 	char *dataptr;
-	char databuffer[DATA_BUFFER_LEN];
+	char *databuffer;
+	size_t _rxLength;
+	WebSocketDecoder _decoder;
 	char key[28];
-	const char *_host;
+	const char *_host = NULL;
 	unsigned int _port;
-	unsigned long pingInterval;
+	// the heartbeat, EIO3 pings go out every _pingInterval ms from lastPing,
+	// the connection is dead once nothing came for _pingInterval + _pingTimeout ms
+	socketIOProtocol_t _protocol = sIOprotocol_EIO3;
+	bool _eio4 = false;  // of the current connection
+	unsigned long _pingInterval = 25000;
+	unsigned long _pingTimeout = 20000;
+	size_t _maxPayload = 0;
 	unsigned long lastPing;
+	unsigned long _lastReceived = 0;
 	const char* _root_ca;
 
 	void findColon(char which);
 	void terminateCommand(void);
-	bool waitForInput(void);
-	void eatHeader(void);
-	bool clientConnected(void);
-
-	void sendMESSAGE(const String &message);
-	String constructMESSAGE(socketIOmessageType_t type, const char* event, const char* payload = NULL, const char * id = NULL);
-	void triggerEvent(const socketIOPacket_t &packet);
-	void triggerAck(const socketIOPacket_t &packet);
-	std::map<String, callback_fn> _events;
-	std::map<String, ackCallback_fn> _acks;
-	size_t _ackId = 1;
+
+	void handleMessage();
+	// The event whose data is being streamed and its namespace, see handlePartial()
+	const char *_streamEvent = NULL;
+	uint8_t _streamNsp = 0;
+	void handlePartial();
+	bool streamTail();
+	void stream(socketIOStreamPhase_t phase, const char *data = NULL, size_t length = 0);
+	void handleControl();
+#ifdef SOCKETIO_DEFLATE
+	// Messages are inflated in place in databuffer. Outgoing ones are staged at
+	// the end of _txBuffer and compressed into its free space, in front of them
+	WebSocketInflater _inflater;
+	WebSocketDeflater _deflater;
+	socketIOCompression_t _compression;
+	bool _deflateActive = false;
+	bool _deflateRejected = false;
+	bool _deflating = false;
+	wsOpcode_t _deflateOpcode;
+	size_t _deflateLength;
+	size_t _deflateFilled;
+	bool inflateMessage();
+	void deflateFrame();
+#endif
+
+	// A binary event or ack waits for its attachments at the start of databuffer,
+	// the decoder assembles them behind it
+	socketIOBinaryMode_t _binaryMode = sIObinary_NATIVE;
+	bool _binaryBase64 = false;
+	socketIOmessageType_t _binaryType;
+	socketIOPacketView_t _binaryPacket;
+	socketIOAttachments_t _attachments;
+	size_t _attachmentsPending = 0;
+	bool _attachmentsDropped = false;
+	void beginAttachments(socketIOmessageType_t type, const socketIOPacketView_t &packet);
+	void handleAttachment(bool dropped = false);
+
+	// Outgoing frames are serialized and masked in place in _txBuffer,
+	// which also queues them until the flush policy sends them in one write.
+	// A short write leaves the rest at its start for loop() to resume
+	uint8_t *_txBuffer;
+	size_t _txLength;
+	WebSocketWriter _writer;
+	socketIOFlushPolicy_t _flushPolicy;
+	size_t _queuedFrames = 0;
+	unsigned long _queuedSince = 0;
+	unsigned long _droppedFrames = 0;
+	bool _txPieces = false;
+	bool _txAborted = false;
+	bool _drainWanted = false;
+	drainCallback_fn _drainCallback;
+	bool beginFrame(wsOpcode_t opcode, size_t length, size_t following = 0);
+	void appendFrame(const void *data, size_t length);
+	void endFrame(bool more = false);
+	bool flushTx();
+	bool drainTx();
+	void discardTx();
+	bool flushDue() const;
+	bool sendFrame(wsOpcode_t opcode, const uint8_t *payload, size_t length);
+	// emitArgs() serializes its packet into the free space of _txBuffer,
+	// behind room for the frame header, and frames it in place
+	template <typename E, typename... Args>
+	bool emitTyped(uint8_t nsp, const E &event, const Args &... args) {
+		for (int attempt = 0; attempt < 2; attempt++) {
+			socketIOJsonWriter_t out = emitWriter();
+			emitHead(out, nsp, event);
+			socketIOJsonArgs(out, args...);
+			out.raw("]", 1);
+			if (!out.overflow()) return emitSerialized(out, nsp);
+			if (!emitRoom()) break;
+		}
+		return emitOverflow();
+	}
+	socketIOJsonWriter_t emitWriter();
+	void emitHead(socketIOJsonWriter_t &out, uint8_t nsp, const char *event);
+	void emitHead(socketIOJsonWriter_t &out, uint8_t nsp, const socketIOEvent_t &event);
+	bool emitRoom();
+	bool emitSerialized(const socketIOJsonWriter_t &out, uint8_t nsp);
+	bool sendSerialized(char *packet, size_t length, bool hold);
+	bool emitOverflow();
+	bool emitTo(uint8_t nsp, const char *event, const char *content, ackCallback_fn cb);
+	bool emitBinaryTo(uint8_t nsp, const char *event, const uint8_t *data, size_t length, binaryAckCallback_fn cb);
+	bool sendPacket(socketIOmessageType_t type, const socketIOView_t &event, const char* payload = NULL, const socketIOView_t &id = socketIOView_t(), size_t attachments = 0, const socketIOView_t &nsp = socketIOView_t(), size_t following = 0);
+	bool sendBinary(socketIOmessageType_t type, const socketIOView_t &event, const uint8_t *data, size_t length, const socketIOView_t &id = socketIOView_t(), const socketIOView_t &nsp = socketIOView_t());
+	bool sendAttachment(const uint8_t *data, size_t length);
+	bool parsePacket(socketIOmessageType_t type, const char *payload, size_t length, socketIOPacketView_t &packet);
+	void triggerEvent(const socketIOPacketView_t &packet, const socketIOAttachments_t *attachments = NULL);
+	void dispatchEvent(const socketIOPacketView_t &packet, const socketIOAttachments_t *attachments);
+	void triggerAck(const socketIOPacketView_t &packet, const socketIOAttachments_t *attachments = NULL);
+	friend class socketIOAck_t;
+	// SocketIOTask takes the events of the default namespace in place of the handlers
+	friend class SocketIOTaskBase;
+	// extras/host's socketio_replay, which reports every event like the task
+	friend class SocketIOReplay;
+	std::function<void (const socketIOPacketView_t &packet)> _eventSink;
+
+	// _namespaces[0] is the default namespace, the others come from of()
+	friend class SocketIONamespace;
+	SocketIONamespace _namespaces[SOCKETIO_MAX_NAMESPACES];
+	size_t _namespaceCount = 1;
+	/// @return the index of the namespace of a received packet, -1 if it is not in use
+	int findNamespace(const socketIOView_t &nsp) const;
+	void sendNamespace(socketIOmessageType_t type, uint8_t nsp);
+	void namespaceConnected(uint8_t nsp, bool connected);
+
+	// Handlers of all namespaces, sorted by the hash of their event name
+	handler_t *_handlers;
+	size_t _maxHandlers;
+	size_t _handlerCount = 0;
+	const socketIOHandler_t *_staticHandlers = NULL;
+	size_t _staticHandlerCount = 0;
+	handler_t *findHandler(const char *event, bool create, uint8_t nsp = 0);
+	handler_t *replaceHandler(const char *event, uint8_t nsp);
+	static void takeCallbacks(handler_t &to, handler_t &from);
+	void returnCallbacks(const char *event, uint8_t nsp, handler_t &callbacks);
+	handler_t *findHandler(const socketIOView_t &event, uint8_t nsp = 0);
+	// Callbacks of emitted events waiting for their ack, id 0 marks a free slot
+	ack_t *_acks;
+	size_t _maxAcks;
+	size_t _ackCount = 0;
+	uint32_t _ackId = 0;
+	socketIOAckPolicy_t _ackPolicy;
+	ack_t *addAck(ack_t &evicted);
+	void expireAck(ack_t &ack);
+	void expireAcks(bool all, int nsp = -1);
 
 	/**
 	 * Parses the payload into a socketIOPacket_t.
 	 * The payload has the following format: ID[EVENT,DATA]
 	 * socketIOPacket_t contains the id, event and data.
+	 * Compatibility wrapper around the view parser, string data is unquoted.
 	 * @param payload std::string
 	 */
 	socketIOPacket_t parse(const std::string &payload);
 
-	void sendCode(const String& code);
+	void sendCode(const char *code);
 	void sendPing();
 	void sendPong();
 };
 
+/// Bytes SocketIOClientT<...> takes, in its buffers and tables and in all
+struct socketIOFootprint_t {
+    size_t rx;
+    size_t tx;
+    size_t handlers;
+    size_t acks;
+    size_t total;
+};
+
+/**
+ * A client whose receive and transmit buffers, handler table and ack table
+ * have the sizes given here, held in the object itself: sizeof() is all the
+ * memory it needs, wherever it is placed, and footprint() tells how it is
+ * spent. Events up to RxBytes - 1 bytes are received whole, packets and
+ * handshake requests have to fit TxBytes, see SocketIOClient for the
+ * defaults.
+ */
+template <size_t RxBytes, size_t TxBytes, size_t MaxHandlers, size_t MaxPendingAcks>
+class SocketIOClientT : public SocketIOClientBase {
+	// the handshake goes through the buffers: response header lines, the upgrade request
+	static_assert(RxBytes >= 128, "the receive buffer has to hold the handshake's header lines");
+	static_assert(TxBytes >= 320, "the transmit buffer has to hold the upgrade request");
+	static_assert(MaxHandlers > 0 && MaxPendingAcks > 0, "at least one handler and one ack slot");
+
+public:
+	SocketIOClientT() : SocketIOClientBase(_rx, RxBytes, _tx, TxBytes, _handlerTable, MaxHandlers, _ackTable, MaxPendingAcks) {}
+
+	static constexpr socketIOFootprint_t footprint() {
+		return socketIOFootprint_t{ RxBytes, TxBytes, MaxHandlers * sizeof(handler_t),
+			MaxPendingAcks * sizeof(ack_t), sizeof(SocketIOClientT) };
+	}
+
+private:
+	char _rx[RxBytes];
+	uint8_t _tx[TxBytes];
+	handler_t _handlerTable[MaxHandlers];
+	ack_t _ackTable[MaxPendingAcks];
+};
+
+typedef SocketIOClientT<DATA_BUFFER_LEN, TX_BUFFER_LEN, SOCKETIO_MAX_HANDLERS, SOCKETIO_MAX_ACKS> SocketIOClient;
+
+template <typename... Args>
+bool SocketIONamespace::emitArgs(const char *event, const Args &... args) {
+	return _client->emitTyped(_index, event, args...);
+}
+
+template <typename... Args>
+bool SocketIONamespace::emitArgs(const socketIOEvent_t &event, const Args &... args) {
+	return _client->emitTyped(_index, event, args...);
+}
+
 #endif
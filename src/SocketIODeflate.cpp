@@ -0,0 +1,463 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Supports Socket.io v1.x
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <SocketIODeflate.h>
+
+#ifdef SOCKETIO_DEFLATE
+
+// RFC 1951 3.2.5, length codes 257..285 and distance codes 0..29
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+// order the code length code lengths are sent in, RFC 1951 3.2.7
+static const uint8_t codeLengthOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+int webSocketDeflateOffer(char *buffer, size_t size) {
+#if SOCKETIO_INFLATE_WINDOW_BITS
+    return snprintf(buffer, size,
+        "permessage-deflate; server_max_window_bits=%d; client_no_context_takeover; client_max_window_bits",
+        SOCKETIO_INFLATE_WINDOW_BITS);
+#else
+    return snprintf(buffer, size,
+        "permessage-deflate; server_no_context_takeover; client_no_context_takeover; client_max_window_bits");
+#endif
+}
+
+static bool matches(const char *token, size_t length, const char *name) {
+    return strlen(name) == length && strncasecmp(token, name, length) == 0;
+}
+
+bool webSocketDeflateAccept(const char *extensions, uint8_t &clientWindowBits) {
+    bool serverNoContextTakeover = false;
+    uint8_t serverWindowBits = 15;
+    clientWindowBits = 15;
+
+    const char *p = extensions;
+    for (size_t index = 0; *p; index++) {
+        while (*p == ' ' || *p == '\t') p++;
+        const char *token = p;
+        while (*p && *p != ';' && *p != '=' && *p != ' ' && *p != ',') p++;
+        size_t length = p - token;
+        long value = -1;
+        while (*p == ' ') p++;
+        if (*p == '=') {
+            p++;
+            if (*p == '"') p++;
+            value = strtol(p, (char **)&p, 10);
+            if (*p == '"') p++;
+            while (*p == ' ') p++;
+        }
+        if (*p == ',') return false;  // a second extension, none was offered
+        if (*p == ';') p++;
+
+        if (index == 0) {
+            if (!matches(token, length, "permessage-deflate") || value != -1) return false;
+        } else if (matches(token, length, "server_no_context_takeover") && value == -1) {
+            serverNoContextTakeover = true;
+        } else if (matches(token, length, "client_no_context_takeover") && value == -1) {
+            // the client never takes over its context anyway
+        } else if (matches(token, length, "server_max_window_bits") && value >= 8 && value <= 15) {
+            serverWindowBits = value;
+        } else if (matches(token, length, "client_max_window_bits") && value >= 8 && value <= 15) {
+            clientWindowBits = value;
+        } else {
+            return false;
+        }
+    }
+#if SOCKETIO_INFLATE_WINDOW_BITS
+    (void)serverNoContextTakeover;
+    return serverWindowBits <= SOCKETIO_INFLATE_WINDOW_BITS;
+#else
+    (void)serverWindowBits;
+    return serverNoContextTakeover;
+#endif
+}
+
+void WebSocketInflater::reset() {
+#if SOCKETIO_INFLATE_WINDOW_BITS
+    _windowLength = 0;
+    _windowPosition = 0;
+#endif
+}
+
+bool WebSocketInflater::inflate(uint8_t *buffer, size_t length, size_t capacity, size_t &inflated) {
+    if (length > capacity) return false;
+    memmove(&buffer[capacity - length], buffer, length);
+    _in = &buffer[capacity - length];
+    _inEnd = &buffer[capacity];
+    _bits = 0;
+    _bitCount = 0;
+    _error = false;
+    _out = buffer;
+    _outLength = 0;
+
+    uint16_t lengthSymbols[288];
+    uint16_t distanceSymbols[30];
+    huffman_t lengths = { {0}, lengthSymbols };
+    huffman_t distances = { {0}, distanceSymbols };
+
+    bool final = false;
+    while (!final && !_error) {
+        final = getBits(1);
+        switch (getBits(2)) {
+            case 0:
+                // the 00 00 FF FF of the closing sync flush is left out of the message
+                _bits >>= _bitCount & 7;
+                _bitCount -= _bitCount & 7;
+                if (_bitCount == 0 && _in == _inEnd) {
+                    final = true;
+                    break;
+                }
+                inflateStored();
+                break;
+            case 1: {
+                uint8_t fixed[288 + 30];
+                memset(fixed, 8, 144);
+                memset(&fixed[144], 9, 112);
+                memset(&fixed[256], 7, 24);
+                memset(&fixed[280], 8, 8);
+                memset(&fixed[288], 5, 30);
+                buildTree(lengths, fixed, 288);
+                buildTree(distances, &fixed[288], 30);
+                inflateBlock(lengths, distances);
+                break;
+            }
+            case 2:
+                if (readTrees(lengths, distances)) {
+                    inflateBlock(lengths, distances);
+                }
+                break;
+            default:
+                _error = true;
+                break;
+        }
+    }
+    if (_error) return false;
+    inflated = _outLength;
+
+#if SOCKETIO_INFLATE_WINDOW_BITS
+    // keep the end of the message for the back references of the next ones
+    const size_t size = sizeof(_window);
+    const uint8_t *p = _outLength > size ? &_out[_outLength - size] : _out;
+    for (const uint8_t *end = &_out[_outLength]; p < end; p++) {
+        _window[_windowPosition] = *p;
+        _windowPosition = (_windowPosition + 1) & (size - 1);
+    }
+    _windowLength = _windowLength + _outLength < size ? _windowLength + _outLength : size;
+#endif
+    return true;
+}
+
+uint32_t WebSocketInflater::getBits(uint8_t count) {
+    while (_bitCount < count) {
+        if (_in == _inEnd) {
+            _error = true;
+            return 0;
+        }
+        _bits |= (uint32_t)*_in++ << _bitCount;
+        _bitCount += 8;
+    }
+    uint32_t value = _bits & ((1UL << count) - 1);
+    _bits >>= count;
+    _bitCount -= count;
+    return value;
+}
+
+bool WebSocketInflater::put(uint8_t c) {
+    // the output must not catch up with the input still to be read
+    if (&_out[_outLength] >= _in) {
+        _error = true;
+        return false;
+    }
+    _out[_outLength++] = c;
+    return true;
+}
+
+bool WebSocketInflater::buildTree(huffman_t &tree, const uint8_t *lengths, size_t count) {
+    memset(tree.counts, 0, sizeof(tree.counts));
+    for (size_t i = 0; i < count; i++) {
+        tree.counts[lengths[i]]++;
+    }
+    tree.counts[0] = 0;
+
+    uint16_t offsets[16];
+    int left = 1;
+    offsets[1] = 0;
+    for (int length = 1; length < 16; length++) {
+        left = (left << 1) - tree.counts[length];
+        if (left < 0) return false;  // over-subscribed, incomplete codes are fine
+        if (length < 15) offsets[length + 1] = offsets[length] + tree.counts[length];
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i]) {
+            tree.symbols[offsets[lengths[i]]++] = i;
+        }
+    }
+    return true;
+}
+
+int WebSocketInflater::decodeSymbol(const huffman_t &tree) {
+    // canonical codes: walk down one length at a time, counting the codes passed
+    int sum = 0;
+    int code = 0;
+    int length = 0;
+    do {
+        code = (code << 1) | getBits(1);
+        if (++length > 15 || _error) {
+            _error = true;
+            return -1;
+        }
+        sum += tree.counts[length];
+        code -= tree.counts[length];
+    } while (code >= 0);
+    return tree.symbols[sum + code];
+}
+
+bool WebSocketInflater::readTrees(huffman_t &lengths, huffman_t &distances) {
+    size_t literals = getBits(5) + 257;
+    size_t distanceCodes = getBits(5) + 1;
+    size_t codeLengthCodes = getBits(4) + 4;
+    if (_error || literals > 286 || distanceCodes > 30) {
+        _error = true;
+        return false;
+    }
+
+    uint8_t codeLengths[288 + 32];
+    memset(codeLengths, 0, 19);
+    for (size_t i = 0; i < codeLengthCodes; i++) {
+        codeLengths[codeLengthOrder[i]] = getBits(3);
+    }
+    // the code length codes borrow the symbols of the literal/length tree
+    if (!buildTree(lengths, codeLengths, 19)) {
+        _error = true;
+        return false;
+    }
+
+    size_t total = literals + distanceCodes;
+    for (size_t n = 0; n < total && !_error;) {
+        int symbol = decodeSymbol(lengths);
+        if (symbol < 0) break;
+        if (symbol < 16) {
+            codeLengths[n++] = symbol;
+            continue;
+        }
+        uint8_t value = 0;
+        size_t repeat;
+        if (symbol == 16) {
+            if (n == 0) {
+                _error = true;
+                break;
+            }
+            value = codeLengths[n - 1];
+            repeat = 3 + getBits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + getBits(3);
+        } else {
+            repeat = 11 + getBits(7);
+        }
+        if (n + repeat > total) {
+            _error = true;
+            break;
+        }
+        memset(&codeLengths[n], value, repeat);
+        n += repeat;
+    }
+    if (_error || codeLengths[256] == 0 ||
+        !buildTree(lengths, codeLengths, literals) ||
+        !buildTree(distances, &codeLengths[literals], distanceCodes)) {
+        _error = true;
+        return false;
+    }
+    return true;
+}
+
+bool WebSocketInflater::inflateStored() {
+    uint32_t length = getBits(16);
+    uint32_t complement = getBits(16);
+    if (_error || length != (~complement & 0xFFFF) || (size_t)(_inEnd - _in) < length) {
+        _error = true;
+        return false;
+    }
+    while (length--) {
+        if (!put(*_in++)) return false;
+    }
+    return true;
+}
+
+bool WebSocketInflater::inflateBlock(const huffman_t &lengths, const huffman_t &distances) {
+    for (;;) {
+        int symbol = decodeSymbol(lengths);
+        if (symbol < 0) return false;
+        if (symbol < 256) {
+            if (!put(symbol)) return false;
+            continue;
+        }
+        if (symbol == 256) return true;
+
+        symbol -= 257;
+        if (symbol >= 29) {
+            _error = true;
+            return false;
+        }
+        size_t length = lengthBase[symbol] + getBits(lengthExtra[symbol]);
+        int distanceSymbol = decodeSymbol(distances);
+        if (distanceSymbol < 0 || distanceSymbol >= 30) {
+            _error = true;
+            return false;
+        }
+        size_t distance = distanceBase[distanceSymbol] + getBits(distanceExtra[distanceSymbol]);
+        if (_error) return false;
+
+        while (length--) {
+            uint8_t c;
+            if (distance <= _outLength) {
+                c = _out[_outLength - distance];
+            } else {
+#if SOCKETIO_INFLATE_WINDOW_BITS
+                size_t back = distance - _outLength;
+                if (back > _windowLength) {
+                    _error = true;
+                    return false;
+                }
+                c = _window[(_windowPosition - back) & (sizeof(_window) - 1)];
+#else
+                _error = true;
+                return false;
+#endif
+            }
+            if (!put(c)) return false;
+        }
+    }
+}
+
+static inline uint32_t hash3(const uint8_t *p) {
+    uint32_t value = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+    return (uint32_t)(value * 2654435761UL) >> (32 - SOCKETIO_DEFLATE_HASH_BITS);
+}
+
+size_t WebSocketDeflater::deflate(const uint8_t *data, size_t length, uint8_t *out, size_t capacity) {
+    if (length >= 0xFFFF) return 0;  // positions are kept in 16 bits
+    memset(_head, 0, sizeof(_head));
+    _out = out;
+    _outEnd = out + capacity;
+    _bits = 0;
+    _bitCount = 0;
+    _full = false;
+
+    putBits(2, 3);  // BFINAL 0, BTYPE 01: fixed Huffman codes
+    size_t position = 0;
+    while (position < length && !_full) {
+        size_t best = 0;
+        size_t distance = 0;
+        if (position + 3 <= length) {
+            uint16_t &head = _head[hash3(&data[position])];
+            if (head && position - (head - 1) <= _window) {
+                const uint8_t *candidate = &data[head - 1];
+                size_t max = length - position < 258 ? length - position : 258;
+                while (best < max && candidate[best] == data[position + best]) best++;
+                distance = position - (head - 1);
+            }
+            head = position + 1;
+        }
+        if (best < 3) {
+            putLiteral(data[position++]);
+            continue;
+        }
+        putMatch(best, distance);
+        // index the positions the match skips, so later matches can start there
+        size_t end = position + best;
+        for (position++; position < end; position++) {
+            if (position + 3 <= length) {
+                _head[hash3(&data[position])] = position + 1;
+            }
+        }
+    }
+    putLiteral(256);  // end of block
+    putBits(0, 3);    // sync flush: empty stored block, its 00 00 FF FF is not sent
+    if (_bitCount) {
+        putBits(0, 8 - _bitCount);
+    }
+    return _full ? 0 : _out - out;
+}
+
+void WebSocketDeflater::putBits(uint32_t value, uint8_t count) {
+    _bits |= value << _bitCount;
+    _bitCount += count;
+    while (_bitCount >= 8) {
+        if (_out == _outEnd) {
+            _full = true;
+            _bitCount = 0;
+            return;
+        }
+        *_out++ = _bits;
+        _bits >>= 8;
+        _bitCount -= 8;
+    }
+}
+
+void WebSocketDeflater::putCode(uint16_t code, uint8_t length) {
+    // Huffman codes are packed starting with their most significant bit
+    uint32_t reversed = code;
+    reversed = ((reversed & 0x5555) << 1) | ((reversed >> 1) & 0x5555);
+    reversed = ((reversed & 0x3333) << 2) | ((reversed >> 2) & 0x3333);
+    reversed = ((reversed & 0x0F0F) << 4) | ((reversed >> 4) & 0x0F0F);
+    reversed = ((reversed & 0x00FF) << 8) | ((reversed >> 8) & 0x00FF);
+    putBits(reversed >> (16 - length), length);
+}
+
+void WebSocketDeflater::putLiteral(uint16_t symbol) {
+    if (symbol < 144) {
+        putCode(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        putCode(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        putCode(symbol - 256, 7);
+    } else {
+        putCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+void WebSocketDeflater::putMatch(size_t length, size_t distance) {
+    int code = 28;
+    while (lengthBase[code] > length) code--;
+    putLiteral(257 + code);
+    putBits(length - lengthBase[code], lengthExtra[code]);
+
+    code = 29;
+    while (distanceBase[code] > distance) code--;
+    putCode(code, 5);
+    putBits(distance - distanceBase[code], distanceExtra[code]);
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _SOCKET_IO_DEFLATE_H
+#define _SOCKET_IO_DEFLATE_H
+
+#include <Arduino.h>
+
+#ifdef SOCKETIO_DEFLATE
+
+// History kept of the server's previous messages, 2^bits bytes. 0 asks the
+// server for server_no_context_takeover and inflates without any window memory
+#ifndef SOCKETIO_INFLATE_WINDOW_BITS
+#define SOCKETIO_INFLATE_WINDOW_BITS 0
+#endif
+#if SOCKETIO_INFLATE_WINDOW_BITS && (SOCKETIO_INFLATE_WINDOW_BITS < 9 || SOCKETIO_INFLATE_WINDOW_BITS > 15)
+#error "SOCKETIO_INFLATE_WINDOW_BITS has to be 0 or 9 to 15"
+#endif
+// Entries of the deflater's match finder, 2 bytes each
+#ifndef SOCKETIO_DEFLATE_HASH_BITS
+#define SOCKETIO_DEFLATE_HASH_BITS 8
+#endif
+
+/**
+ * Writes the Sec-WebSocket-Extensions offer matching SOCKETIO_INFLATE_WINDOW_BITS.
+ * The client never refers to its previous messages, so it also offers
+ * client_no_context_takeover and accepts any client_max_window_bits.
+ */
+int webSocketDeflateOffer(char *buffer, size_t size);
+
+/**
+ * Checks the server's answer to the offer.
+ * @param clientWindowBits set to the window the server allows the client
+ * @return false if the answer is not one the offer allows
+ */
+bool webSocketDeflateAccept(const char *extensions, uint8_t &clientWindowBits);
+
+/**
+ * Raw DEFLATE decoder for permessage-deflate (RFC 7692) messages.
+ * Inflates in place: the compressed message is moved to the end of the
+ * buffer and inflated into its start, the output only has to stay behind the
+ * input still to be read. Back references reach into the message itself,
+ * and into a window of the previous messages if SOCKETIO_INFLATE_WINDOW_BITS
+ * is set. The Huffman tables live on the stack while a message is inflated.
+ */
+class WebSocketInflater {
+public:
+    void reset();
+
+    /**
+     * The end of the message, the end-of-block code and the header of the
+     * closing empty block, is still to be read when its last byte comes out:
+     * capacity has to leave those few bytes behind the inflated message.
+     * @param buffer holds the compressed message at its start
+     * @param capacity bytes of buffer the message may be inflated to
+     * @param inflated the length of the inflated message at the start of buffer
+     * @return false if the message is corrupt or does not fit
+     */
+    bool inflate(uint8_t *buffer, size_t length, size_t capacity, size_t &inflated);
+
+private:
+    struct huffman_t {
+        uint16_t counts[16];
+        uint16_t *symbols;
+    };
+
+    bool buildTree(huffman_t &tree, const uint8_t *lengths, size_t count);
+    bool readTrees(huffman_t &lengths, huffman_t &distances);
+    bool inflateBlock(const huffman_t &lengths, const huffman_t &distances);
+    bool inflateStored();
+    int decodeSymbol(const huffman_t &tree);
+    uint32_t getBits(uint8_t count);
+    bool put(uint8_t c);
+
+    const uint8_t *_in;
+    const uint8_t *_inEnd;
+    uint32_t _bits;
+    uint8_t _bitCount;
+    bool _error;
+    uint8_t *_out;
+    size_t _outLength;
+#if SOCKETIO_INFLATE_WINDOW_BITS
+    uint8_t _window[1 << SOCKETIO_INFLATE_WINDOW_BITS];
+    size_t _windowLength = 0;
+    size_t _windowPosition = 0;
+#endif
+};
+
+/**
+ * Raw DEFLATE encoder for permessage-deflate messages: greedy LZ77 matching
+ * through a small hash table and a single block of fixed Huffman codes,
+ * ended with the sync flush whose 00 00 FF FF trailer the extension drops.
+ * Every message is compressed on its own, without context takeover.
+ */
+class WebSocketDeflater {
+public:
+    void setWindowBits(uint8_t bits) { _window = 1UL << bits; }
+
+    /**
+     * Compresses data into out, which must not overlap it.
+     * @return the compressed length, 0 if it would exceed capacity
+     */
+    size_t deflate(const uint8_t *data, size_t length, uint8_t *out, size_t capacity);
+
+private:
+    void putBits(uint32_t value, uint8_t count);
+    void putCode(uint16_t code, uint8_t length);
+    void putLiteral(uint16_t symbol);
+    void putMatch(size_t length, size_t distance);
+
+    uint16_t _head[1 << SOCKETIO_DEFLATE_HASH_BITS];
+    size_t _window = 32768;
+    uint8_t *_out;
+    uint8_t *_outEnd;
+    uint32_t _bits;
+    uint8_t _bitCount;
+    bool _full;
+};
+
+#endif
+#endif
@@ -0,0 +1,325 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Supports Socket.io v1.x
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <SocketIOFrame.h>
+
+WebSocketDecoder::WebSocketDecoder(uint8_t *buffer, size_t capacity) :
+    _buffer(buffer), _capacity(capacity) {
+    reset();
+}
+
+void WebSocketDecoder::reset() {
+    _state = wsState_HEADER;
+    _headerLength = 0;
+    _headerWanted = 2;
+    _base = 0;
+    _length = 0;
+    _truncated = false;
+    _fragmented = false;
+    _compressed = false;
+    _remaining = 0;
+    _controlLength = 0;
+    _buffer[0] = 0;
+}
+
+size_t WebSocketDecoder::want(uint8_t *&dst) {
+    switch (_state) {
+        case wsState_HEADER:
+        case wsState_EXT_LENGTH:
+            dst = &_header[_headerLength];
+            return _headerWanted - _headerLength;
+        case wsState_MASK:
+            dst = &_mask[_headerLength];
+            return 4 - _headerLength;
+        case wsState_PAYLOAD:
+        default:
+            break;
+    }
+
+    if (_frameHeader & 0x08) {
+        // control frames are at most 125 bytes, checked in commit()
+        dst = &_control[_controlLength];
+        return _remaining;
+    }
+
+    size_t room = _capacity - 1 - _base - _length;
+    if (room == 0) {
+        // message does not fit, discard the rest of it through the control buffer
+        dst = _control;
+        return _remaining < WS_MAX_CONTROL_LEN ? _remaining : WS_MAX_CONTROL_LEN;
+    }
+    dst = &_buffer[_base + _length];
+    return _remaining < room ? _remaining : room;
+}
+
+wsDecodeResult_t WebSocketDecoder::commit(size_t length) {
+    if (length == 0) return wsDecode_NEED_MORE;
+
+    if (_state != wsState_PAYLOAD) {
+        _headerLength += length;
+        if (_headerLength < (_state == wsState_MASK ? 4 : _headerWanted)) return wsDecode_NEED_MORE;
+    }
+
+    switch (_state) {
+        case wsState_HEADER: {
+            _frameHeader = _header[0];
+            _masked = _header[1] & 0x80;
+            _remaining = _header[1] & 0x7F;
+            wsOpcode_t op = (wsOpcode_t)(_frameHeader & 0x0F);
+
+            if (_frameHeader & 0x30) return wsDecode_ERROR;  // RSV2 and RSV3 belong to no negotiated extension
+            // RSV1 marks the first frame of a compressed data message
+            if ((_frameHeader & 0x40) && (!_allowCompression || (op & 0x08) || op == wsOp_CONTINUATION)) return wsDecode_ERROR;
+            if (op & 0x08) {
+                if (!(_frameHeader & 0x80) || _remaining > WS_MAX_CONTROL_LEN) return wsDecode_ERROR;
+                if (op != wsOp_CLOSE && op != wsOp_PING && op != wsOp_PONG) return wsDecode_ERROR;
+            } else if (op == wsOp_CONTINUATION) {
+                if (!_fragmented) return wsDecode_ERROR;
+            } else if (op == wsOp_TEXT || op == wsOp_BINARY) {
+                if (_fragmented) return wsDecode_ERROR;
+                _messageOpcode = op;
+                _length = 0;
+                _truncated = false;
+                _compressed = _frameHeader & 0x40;
+            } else {
+                return wsDecode_ERROR;
+            }
+
+            _headerLength = 0;
+            if (_remaining >= 126) {
+                _headerWanted = _remaining == 126 ? 2 : 8;
+                _state = wsState_EXT_LENGTH;
+                return wsDecode_NEED_MORE;
+            }
+            if (_masked) {
+                _state = wsState_MASK;
+                return wsDecode_NEED_MORE;
+            }
+            return beginPayload();
+        }
+
+        case wsState_EXT_LENGTH:
+            _remaining = 0;
+            for (uint8_t i = 0; i < _headerWanted; i++) {
+                _remaining = (_remaining << 8) | _header[i];
+            }
+            if (_remaining >> 63) return wsDecode_ERROR;
+            _headerLength = 0;
+            if (_masked) {
+                _state = wsState_MASK;
+                return wsDecode_NEED_MORE;
+            }
+            return beginPayload();
+
+        case wsState_MASK:
+            return beginPayload();
+
+        case wsState_PAYLOAD:
+        default:
+            break;
+    }
+
+    uint8_t *data;
+    want(data);  // the destination the caller was handed, state has not moved yet
+    if (_masked) {
+        for (size_t i = 0; i < length; i++) {
+            data[i] ^= _mask[(_frameOffset + i) & 3];
+        }
+    }
+    _frameOffset += length;
+    _remaining -= length;
+
+    if (_frameHeader & 0x08) {
+        _controlLength += length;
+    } else if (data == _control) {
+        _truncated = true;
+    } else {
+        _length += length;
+    }
+
+    wsDecodeResult_t result = _remaining == 0 ? endFrame() : wsDecode_NEED_MORE;
+    if (result == wsDecode_NEED_MORE && _allowPartial && !(_frameHeader & 0x08) && data != _control &&
+        !_compressed && _base + _length == _capacity - 1) {
+        _opcode = _messageOpcode;
+        _buffer[_base + _length] = 0;
+        return wsDecode_PARTIAL;
+    }
+    return result;
+}
+
+wsDecodeResult_t WebSocketDecoder::feed(const uint8_t *data, size_t length, size_t &consumed) {
+    consumed = 0;
+    while (consumed < length) {
+        uint8_t *dst;
+        size_t n = want(dst);
+        if (n > length - consumed) n = length - consumed;
+        memcpy(dst, &data[consumed], n);
+        consumed += n;
+        wsDecodeResult_t result = commit(n);
+        if (result != wsDecode_NEED_MORE) return result;
+    }
+    return wsDecode_NEED_MORE;
+}
+
+wsDecodeResult_t WebSocketDecoder::beginPayload() {
+    _state = wsState_PAYLOAD;
+    _frameOffset = 0;
+    if (_frameHeader & 0x08) {
+        _controlLength = 0;
+    }
+    if (_remaining == 0) return endFrame();
+    return wsDecode_NEED_MORE;
+}
+
+wsDecodeResult_t WebSocketDecoder::endFrame() {
+    _state = wsState_HEADER;
+    _headerLength = 0;
+    _headerWanted = 2;
+
+    if (_frameHeader & 0x08) {
+        _opcode = (wsOpcode_t)(_frameHeader & 0x0F);
+        _control[_controlLength] = 0;
+        return wsDecode_CONTROL;
+    }
+
+    if (!(_frameHeader & 0x80)) {
+        _fragmented = true;
+        return wsDecode_NEED_MORE;
+    }
+    _fragmented = false;
+    _opcode = _messageOpcode;
+    _buffer[_base + _length] = 0;
+    return wsDecode_MESSAGE;
+}
+
+void WebSocketDecoder::discard(size_t length) {
+    if (length > _length) {
+        length = _length;
+    }
+    memmove(&_buffer[_base], &_buffer[_base + length], _length - length);
+    _length -= length;
+    _buffer[_base + _length] = 0;
+}
+
+void WebSocketDecoder::setLength(size_t length) {
+    _length = length;
+    _compressed = false;
+    _buffer[_base + _length] = 0;
+}
+
+WebSocketWriter::WebSocketWriter(uint8_t *buffer, size_t capacity) :
+    _buffer(buffer), _capacity(capacity) {
+}
+
+void WebSocketWriter::seed(uint32_t seed) {
+    if (seed) {
+        _random = seed;
+    }
+}
+
+bool WebSocketWriter::begin(wsOpcode_t opcode, size_t length, bool compressed) {
+    uint64_t msglength = length;
+    size_t headerLength = msglength <= 125 ? 6 : msglength <= 65535 ? 8 : 14;
+    if (space() < headerLength) return false;
+    seal();  // finish the previous frame, its mask ends here
+
+    uint8_t *header = &_buffer[_length];
+    header[0] = 0x80 | opcode | (compressed ? 0x40 : 0);  // FIN, messages are never fragmented
+    int index;
+    if (msglength <= 125) {
+        header[1] = msglength + 128; //size of the message + 128 because message has to be masked
+        index = 2;
+    } else if (msglength <= 65535) {
+        header[1] = 126 + 128;
+        header[2] = (msglength >> 8) & 255;
+        header[3] = (msglength)&255;
+        index = 4;
+    } else {
+        header[1] = 127 + 128;
+        for (int i = 0; i < 8; i++) {
+            header[2 + i] = (msglength >> (56 - 8 * i)) & 255;
+        }
+        index = 10;
+    }
+
+    // xorshift32, a new masking key for every frame
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    memcpy(_mask, &_random, 4);
+    memcpy(&header[index], _mask, 4);
+
+    _length += headerLength;
+    _masked = _length;
+    _offset = 0;
+    return true;
+}
+
+size_t WebSocketWriter::append(const void *data, size_t length) {
+    if (length > space()) {
+        length = space();
+    }
+    memmove(&_buffer[_length], data, length);
+    _length += length;
+    return length;
+}
+
+void WebSocketWriter::seal() {
+    uint8_t *p = &_buffer[_masked];
+    size_t n = _length - _masked;
+    _masked = _length;
+
+    while (n && (_offset & 3)) {
+        *p++ ^= _mask[_offset++ & 3];
+        n--;
+    }
+    uint32_t key;
+    memcpy(&key, _mask, 4);
+    _offset += n & ~3UL;
+    for (; n >= 4; n -= 4, p += 4) {
+        uint32_t word;
+        memcpy(&word, p, 4);
+        word ^= key;
+        memcpy(p, &word, 4);
+    }
+    for (size_t i = 0; i < n; i++) {
+        p[i] ^= _mask[i];
+    }
+    _offset += n;
+}
+
+void WebSocketWriter::clear() {
+    _length = 0;
+    _masked = 0;
+}
+
+void WebSocketWriter::consume(size_t length) {
+    if (length > _masked) {
+        length = _masked;
+    }
+    // the mask position travels with the bytes still to be masked
+    memmove(_buffer, &_buffer[length], _length - length);
+    _length -= length;
+    _masked -= length;
+}
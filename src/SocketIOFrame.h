@@ -0,0 +1,181 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _SOCKET_IO_FRAME_H
+#define _SOCKET_IO_FRAME_H
+
+#include <Arduino.h>
+
+// Longest payload a control frame (close, ping, pong) may carry (RFC 6455 5.5)
+#define WS_MAX_CONTROL_LEN 125
+
+typedef enum : uint8_t {
+    wsOp_CONTINUATION = 0x0,
+    wsOp_TEXT = 0x1,
+    wsOp_BINARY = 0x2,
+    wsOp_CLOSE = 0x8,
+    wsOp_PING = 0x9,
+    wsOp_PONG = 0xA,
+} wsOpcode_t;
+
+typedef enum {
+    wsDecode_NEED_MORE, ///< All input consumed, no complete message yet
+    wsDecode_MESSAGE,   ///< A complete (possibly reassembled) text or binary message is available
+    wsDecode_CONTROL,   ///< A complete close, ping or pong frame is available
+    wsDecode_PARTIAL,   ///< The buffer filled up before the end of a data message, see allowPartial()
+    wsDecode_ERROR,     ///< Protocol violation, the connection has to be dropped
+} wsDecodeResult_t;
+
+/**
+ * Incremental RFC 6455 frame decoder.
+ * Bytes can be handed over in any split: the decoder keeps its position
+ * inside the frame header and payload between calls, reassembles fragmented
+ * messages and keeps control frames apart so they may be interleaved with
+ * the fragments of a data message.
+ *
+ * Data messages are assembled in the buffer given to the constructor and are
+ * always null terminated, so one byte of it is reserved for the terminator.
+ * Messages that do not fit are consumed and reported as truncated, or with
+ * allowPartial() handed out piece by piece as the buffer fills up.
+ *
+ * Input is either pushed with feed(), or read straight into the decoder's
+ * storage: want() tells where the next bytes have to go and how many of them
+ * the current decoding step can take, commit() accounts for what was read.
+ */
+class WebSocketDecoder {
+public:
+    WebSocketDecoder(uint8_t *buffer, size_t capacity);
+
+    void reset();
+
+    size_t want(uint8_t *&dst);
+    wsDecodeResult_t commit(size_t length);
+    wsDecodeResult_t feed(const uint8_t *data, size_t length, size_t &consumed);
+    /**
+     * Keeps the first length bytes of the buffer, e.g. a message that is not
+     * complete without the ones following it, and assembles the next data
+     * messages behind them. retain(0) gives the whole buffer back.
+     */
+    void retain(size_t length) { _base = length < _capacity ? length : _capacity - 1; }
+    /// Accepts data messages with RSV1 set, once permessage-deflate is negotiated
+    void allowCompression(bool allow) { _allowCompression = allow; }
+    /// Replaces the length of the last message after it was transformed in place, e.g. inflated
+    void setLength(size_t length);
+    /**
+     * Reports a full buffer in the middle of an uncompressed data message as
+     * wsDecode_PARTIAL, with payload() and length() the part received so far.
+     * discard() then makes room for the rest, without it the message ends up
+     * truncated as usual.
+     */
+    void allowPartial(bool allow) { _allowPartial = allow; }
+    /// Drops the first length bytes of a partial message, the ones after them move to its start
+    void discard(size_t length);
+
+    /// Opcode, payload and length of the last reported message or control frame
+    wsOpcode_t opcode() const { return _opcode; }
+    const uint8_t *payload() const { return _opcode & 0x8 ? _control : &_buffer[_base]; }
+    size_t length() const { return _opcode & 0x8 ? _controlLength : _length; }
+    bool truncated() const { return _truncated; }
+    /// Nothing of a frame or fragmented message was received yet, the next bytes begin a new message
+    bool atMessageStart() const { return _state == wsState_HEADER && _headerLength == 0 && !_fragmented; }
+    /// The last message was sent with RSV1, compressed with permessage-deflate
+    bool compressed() const { return _compressed; }
+
+private:
+    typedef enum : uint8_t {
+        wsState_HEADER,
+        wsState_EXT_LENGTH,
+        wsState_MASK,
+        wsState_PAYLOAD,
+    } wsState_t;
+
+    wsDecodeResult_t beginPayload();
+    wsDecodeResult_t endFrame();
+
+    uint8_t *_buffer;
+    size_t _capacity;
+    size_t _base = 0;
+    size_t _length = 0;
+    bool _truncated = false;
+    bool _fragmented = false;
+    bool _compressed = false;
+    bool _allowCompression = false;
+    bool _allowPartial = false;
+
+    wsState_t _state = wsState_HEADER;
+    uint8_t _header[8];
+    uint8_t _headerLength = 0;
+    uint8_t _headerWanted = 2;
+    uint8_t _frameHeader = 0;
+    bool _masked = false;
+    uint8_t _mask[4];
+    uint64_t _remaining = 0;
+    uint64_t _frameOffset = 0;
+
+    wsOpcode_t _opcode = wsOp_TEXT;
+    wsOpcode_t _messageOpcode = wsOp_TEXT;
+    uint8_t _control[WS_MAX_CONTROL_LEN + 1];
+    size_t _controlLength = 0;
+};
+
+// Longest client frame header: 2 bytes, 64 bit extended length, masking key
+#define WS_MAX_HEADER_LEN 14
+
+/**
+ * Builds masked client frames in a caller provided transmit buffer.
+ * begin() writes the header for a payload of known length, append() copies
+ * payload bytes behind it for as long as there is space (they may come from
+ * the buffer's own free space, e.g. after compressing there), seal() masks the
+ * bytes appended so far in place, 32 bits at a time. A frame larger than the
+ * buffer is sent in pieces: write out data()/length() once the buffer is
+ * full, then clear() it and keep appending, the mask phase carries over.
+ * Masking keys come from a xorshift generator seeded once per connection.
+ */
+class WebSocketWriter {
+public:
+    WebSocketWriter(uint8_t *buffer, size_t capacity);
+
+    void seed(uint32_t seed);
+
+    bool begin(wsOpcode_t opcode, size_t length, bool compressed = false);
+    size_t append(const void *data, size_t length);
+    void seal();
+    void clear();
+    /// Drops the first length bytes, which have to be sealed, once the socket took them
+    void consume(size_t length);
+
+    const uint8_t *data() const { return _buffer; }
+    size_t length() const { return _length; }
+    size_t space() const { return _capacity - _length; }
+
+private:
+    uint8_t *_buffer;
+    size_t _capacity;
+    size_t _length = 0;
+    size_t _masked = 0;
+    uint32_t _offset = 0;
+    uint8_t _mask[4];
+    uint32_t _random = 2463534242UL;
+};
+
+#endif
@@ -0,0 +1,450 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <SocketIOJson.h>
+#include <stdio.h>
+#include <math.h>
+
+/// Whether any of the 4 bytes is a control character, a quote or a backslash
+static inline bool needsEscape(uint32_t word) {
+    const uint32_t ones = 0x01010101UL, highs = 0x80808080UL;
+    uint32_t quote = word ^ 0x22222222UL, backslash = word ^ 0x5C5C5C5CUL;
+    return ((((word - 0x20 * ones) & ~word) | ((quote - ones) & ~quote) | ((backslash - ones) & ~backslash)) & highs) != 0;
+}
+
+void socketIOJsonWriter_t::string(const char *str, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    raw("\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < length; i++) {
+        // skip 4 bytes at a time while none needs escaping
+        uint32_t word;
+        while (i + 4 <= length) {
+            memcpy(&word, &str[i], 4);
+            if (needsEscape(word)) break;
+            i += 4;
+        }
+        if (i == length) break;
+        uint8_t c = str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        // copy the characters that need no escaping in one go
+        raw(&str[run], i - run);
+        run = i + 1;
+        char escaped[6] = { '\\', (char)c };
+        size_t escapedLength = 2;
+        switch (c) {
+            case '"':
+            case '\\':
+                break;
+            case '\b': escaped[1] = 'b'; break;
+            case '\f': escaped[1] = 'f'; break;
+            case '\n': escaped[1] = 'n'; break;
+            case '\r': escaped[1] = 'r'; break;
+            case '\t': escaped[1] = 't'; break;
+            default:
+                memcpy(escaped, "\\u00", 4);
+                escaped[4] = hex[c >> 4];
+                escaped[5] = hex[c & 15];
+                escapedLength = 6;
+                break;
+        }
+        raw(escaped, escapedLength);
+    }
+    raw(&str[run], length - run);
+    raw("\"", 1);
+}
+
+void socketIOJsonWriter_t::number(unsigned long value) {
+    char digits[20];
+    char *p = &digits[sizeof(digits)];
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    raw(p, &digits[sizeof(digits)] - p);
+}
+
+void socketIOJsonWriter_t::number(long value) {
+    if (value < 0) {
+        raw("-", 1);
+        number(0UL - (unsigned long)value);
+    } else {
+        number((unsigned long)value);
+    }
+}
+
+void socketIOJsonWriter_t::number(unsigned long long value) {
+    if (value <= (unsigned long)-1) {
+        number((unsigned long)value);
+        return;
+    }
+    char digits[20];
+    char *p = &digits[sizeof(digits)];
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    raw(p, &digits[sizeof(digits)] - p);
+}
+
+void socketIOJsonWriter_t::number(long long value) {
+    if (value < 0) {
+        raw("-", 1);
+        number(0ULL - (unsigned long long)value);
+    } else {
+        number((unsigned long long)value);
+    }
+}
+
+void socketIOJsonWriter_t::number(double value, uint8_t digits) {
+    if (isnan(value) || isinf(value)) {
+        null();
+        return;
+    }
+    // whole numbers, common for sensor readings, without going through printf
+    if (fabs(value) < 1e6 && value == (double)(long)value) {
+        number((long)value);
+        return;
+    }
+    char text[32];
+    int length = snprintf(text, sizeof(text), "%.*g", digits, value);
+    if (length > 0) {
+        raw(text, (size_t)length < sizeof(text) ? length : sizeof(text) - 1);
+    }
+}
+
+static inline bool jsonSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static const char *skipSpace(const char *p, const char *end) {
+    while (p < end && jsonSpace(*p)) p++;
+    return p;
+}
+
+/// Past the closing quote of the string whose opening quote is at p, NULL if it has none
+static const char *skipString(const char *p, const char *end) {
+    const char *content = ++p;
+    for (;;) {
+        const char *quote = (const char *)memchr(p, '"', end - p);
+        if (quote == NULL) return NULL;
+        // escaped by an odd number of backslashes before it
+        const char *escapes = quote;
+        while (escapes > content && escapes[-1] == '\\') escapes--;
+        if (((quote - escapes) & 1) == 0) return quote + 1;
+        p = quote + 1;
+    }
+}
+
+/// Past the value at p, tracking strings and brackets as parse() does, NULL if it is malformed
+static const char *skipValue(const char *p, const char *end) {
+    if (p >= end) return NULL;
+    char c = *p;
+    if (c == '"') return skipString(p, end);
+    if (c == '{' || c == '[') {
+        unsigned int depth = 0;
+        while (p < end) {
+            c = *p;
+            if (c == '"') {
+                p = skipString(p, end);
+                if (p == NULL) return NULL;
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) return p + 1;
+            }
+            p++;
+        }
+        return NULL;
+    }
+    const char *start = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ':' && !jsonSpace(*p)) p++;
+    return p > start ? p : NULL;
+}
+
+socketIOJsonCursor_t::socketIOJsonCursor_t(const char *json, size_t length) :
+    socketIOJsonCursor_t(json, json + length, NULL) {
+}
+
+socketIOJsonCursor_t::socketIOJsonCursor_t(const char *value, const char *end, const char *key) {
+    if (value == NULL) return;
+    value = skipSpace(value, end);
+    const char *valueEnd = skipValue(value, end);
+    if (valueEnd == NULL) return;
+    _ptr = value;
+    _length = valueEnd - value;
+    _end = end;
+    _key = key;
+}
+
+socketIOJsonType_t socketIOJsonCursor_t::type() const {
+    if (_ptr == NULL) return sIOjson_MISSING;
+    switch (*_ptr) {
+        case '"': return sIOjson_STRING;
+        case '{': return sIOjson_OBJECT;
+        case '[': return sIOjson_ARRAY;
+        case 't':
+        case 'f': return sIOjson_BOOL;
+        case 'n': return sIOjson_NULL;
+        default: return sIOjson_NUMBER;
+    }
+}
+
+/// The member whose key's opening quote is at p, inside an object ending at end
+socketIOJsonCursor_t socketIOJsonCursor_t::member(const char *p, const char *end) const {
+    if (p >= end || *p != '"') return socketIOJsonCursor_t();
+    const char *key = p;
+    p = skipString(p, end);
+    if (p == NULL) return socketIOJsonCursor_t();
+    p = skipSpace(p, end);
+    if (p == end || *p != ':') return socketIOJsonCursor_t();
+    return socketIOJsonCursor_t(p + 1, end, key);
+}
+
+socketIOJsonCursor_t socketIOJsonCursor_t::first() const {
+    socketIOJsonType_t t = type();
+    if (t != sIOjson_ARRAY && t != sIOjson_OBJECT) return socketIOJsonCursor_t();
+    // inside the brackets
+    const char *end = _ptr + _length - 1;
+    const char *p = skipSpace(_ptr + 1, end);
+    if (p == end) return socketIOJsonCursor_t();
+    return t == sIOjson_OBJECT ? member(p, end) : socketIOJsonCursor_t(p, end, NULL);
+}
+
+socketIOJsonCursor_t socketIOJsonCursor_t::next() const {
+    if (_ptr == NULL) return socketIOJsonCursor_t();
+    const char *p = skipSpace(_ptr + _length, _end);
+    if (p == _end || *p != ',') return socketIOJsonCursor_t();
+    p = skipSpace(p + 1, _end);
+    return _key ? member(p, _end) : socketIOJsonCursor_t(p, _end, NULL);
+}
+
+socketIOJsonCursor_t socketIOJsonCursor_t::key() const {
+    if (_key == NULL) return socketIOJsonCursor_t();
+    return socketIOJsonCursor_t(_key, _end, NULL);
+}
+
+size_t socketIOJsonCursor_t::size() const {
+    size_t count = 0;
+    for (socketIOJsonCursor_t item = first(); item.exists(); item = item.next()) count++;
+    return count;
+}
+
+socketIOJsonCursor_t socketIOJsonCursor_t::operator[](const char *key) const {
+    if (type() != sIOjson_OBJECT) return socketIOJsonCursor_t();
+    size_t length = strlen(key);
+    for (socketIOJsonCursor_t item = first(); item.exists(); item = item.next()) {
+        if ((size_t)(item._ptr - item._key) > length + 1 && memcmp(&item._key[1], key, length) == 0 && item._key[length + 1] == '"') {
+            return item;
+        }
+    }
+    return socketIOJsonCursor_t();
+}
+
+socketIOJsonCursor_t socketIOJsonCursor_t::operator[](size_t index) const {
+    if (type() != sIOjson_ARRAY) return socketIOJsonCursor_t();
+    socketIOJsonCursor_t item = first();
+    while (index-- && item.exists()) {
+        item = item.next();
+    }
+    return item;
+}
+
+socketIOJsonCursor_t socketIOJsonCursor_t::get(const char *path) const {
+    socketIOJsonCursor_t value = *this;
+    while (*path && value.exists()) {
+        const char *dot = strchr(path, '.');
+        size_t length = dot ? (size_t)(dot - path) : strlen(path);
+        char segment[32];
+        if (length >= sizeof(segment)) return socketIOJsonCursor_t();
+        memcpy(segment, path, length);
+        segment[length] = 0;
+        bool index = length > 0 && strspn(segment, "0123456789") == length;
+        if (value.type() == sIOjson_ARRAY && index) {
+            value = value[(size_t)strtoul(segment, NULL, 10)];
+        } else {
+            value = value[segment];
+        }
+        path += length + (dot ? 1 : 0);
+    }
+    return value;
+}
+
+double socketIOJsonCursor_t::asDouble(double fallback) const {
+    if (type() != sIOjson_NUMBER || _length >= 32) return fallback;
+    // the value is not terminated where it lies
+    char number[32];
+    memcpy(number, _ptr, _length);
+    number[_length] = 0;
+    char *end;
+    double value = strtod(number, &end);
+    return end == &number[_length] ? value : fallback;
+}
+
+long socketIOJsonCursor_t::asLong(long fallback) const {
+    if (type() != sIOjson_NUMBER) return fallback;
+    const char *p = _ptr;
+    const char *end = _ptr + _length;
+    bool negative = *p == '-';
+    if (negative) p++;
+    if (p == end) return fallback;
+    unsigned long value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        value = value * 10 + (*p - '0');
+    }
+    if (p != end) return (long)asDouble(fallback);
+    return negative ? -(long)value : (long)value;
+}
+
+unsigned long socketIOJsonCursor_t::asULong(unsigned long fallback) const {
+    if (type() != sIOjson_NUMBER || *_ptr == '-') return fallback;
+    unsigned long value = 0;
+    const char *p = _ptr;
+    const char *end = _ptr + _length;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        value = value * 10 + (*p - '0');
+    }
+    if (p != end) return (unsigned long)asDouble(fallback);
+    return value;
+}
+
+bool socketIOJsonCursor_t::asBool(bool fallback) const {
+    if (_ptr == NULL) return fallback;
+    if (_length == 4 && memcmp(_ptr, "true", 4) == 0) return true;
+    if (_length == 5 && memcmp(_ptr, "false", 5) == 0) return false;
+    return fallback;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static long hex4(const char *p, const char *end) {
+    if (end - p < 4) return -1;
+    long value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hexValue(p[i]);
+        if (digit < 0) return -1;
+        value = value << 4 | digit;
+    }
+    return value;
+}
+
+/**
+ * Decodes the character or escape sequence at p of a string's content,
+ * advancing p past it.
+ * @return its length in UTF-8 written to out, 0 for a malformed escape
+ */
+static size_t decodeChar(const char *&p, const char *end, char out[4]) {
+    if (*p != '\\') {
+        out[0] = *p++;
+        return 1;
+    }
+    if (end - p < 2) return 0;
+    char c = p[1];
+    p += 2;
+    switch (c) {
+        case '"': case '\\': case '/': out[0] = c; return 1;
+        case 'b': out[0] = '\b'; return 1;
+        case 'f': out[0] = '\f'; return 1;
+        case 'n': out[0] = '\n'; return 1;
+        case 'r': out[0] = '\r'; return 1;
+        case 't': out[0] = '\t'; return 1;
+        case 'u': break;
+        default: return 0;
+    }
+    long code = hex4(p, end);
+    if (code < 0) return 0;
+    p += 4;
+    if (code >= 0xD800 && code < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+        // a surrogate pair
+        long low = hex4(p + 2, end);
+        if (low >= 0xDC00 && low < 0xE000) {
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            p += 6;
+        }
+    }
+    if (code < 0x80) {
+        out[0] = code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = 0xC0 | code >> 6;
+        out[1] = 0x80 | (code & 0x3F);
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = 0xE0 | code >> 12;
+        out[1] = 0x80 | (code >> 6 & 0x3F);
+        out[2] = 0x80 | (code & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | code >> 18;
+    out[1] = 0x80 | (code >> 12 & 0x3F);
+    out[2] = 0x80 | (code >> 6 & 0x3F);
+    out[3] = 0x80 | (code & 0x3F);
+    return 4;
+}
+
+size_t socketIOJsonCursor_t::asString(char *buffer, size_t size) const {
+    if (type() != sIOjson_STRING) {
+        if (size) buffer[0] = 0;
+        return 0;
+    }
+    const char *p = _ptr + 1;
+    const char *end = _ptr + _length - 1;
+    size_t length = 0;
+    char decoded[4];
+    while (p < end) {
+        size_t n = decodeChar(p, end, decoded);
+        if (n == 0) break;
+        for (size_t i = 0; i < n; i++, length++) {
+            if (length + 1 < size) buffer[length] = decoded[i];
+        }
+    }
+    if (size) buffer[length < size ? length : size - 1] = 0;
+    return length;
+}
+
+bool socketIOJsonCursor_t::equals(const char *str) const {
+    if (type() != sIOjson_STRING) return false;
+    const char *p = _ptr + 1;
+    const char *end = _ptr + _length - 1;
+    // most strings have no escapes and compare as they are
+    if (memchr(p, '\\', end - p) == NULL) {
+        size_t length = end - p;
+        return strncmp(p, str, length) == 0 && str[length] == 0;
+    }
+    char decoded[4];
+    while (p < end) {
+        size_t n = decodeChar(p, end, decoded);
+        if (n == 0 || strncmp(str, decoded, n) != 0) return false;
+        str += n;
+    }
+    return *str == 0;
+}
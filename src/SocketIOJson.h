@@ -0,0 +1,242 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _SOCKET_IO_JSON_H
+#define _SOCKET_IO_JSON_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+/**
+ * Appends JSON to a fixed buffer without allocating. Writes past the end are
+ * dropped and remembered, check overflow() once done instead of every call.
+ */
+class socketIOJsonWriter_t {
+public:
+    socketIOJsonWriter_t(char *buffer, size_t capacity) : _buffer(buffer), _capacity(capacity) {}
+
+    void raw(const char *data, size_t length) {
+        if (length > _capacity - _length) {
+            _overflow = true;
+            return;
+        }
+        if (length) memcpy(&_buffer[_length], data, length);
+        _length += length;
+    }
+    void raw(const char *str) { raw(str, strlen(str)); }
+    /// A JSON string, quoted and escaped
+    void string(const char *str, size_t length);
+    void string(const char *str) { string(str, strlen(str)); }
+    void number(long value);
+    void number(unsigned long value);
+    void number(long long value);
+    void number(unsigned long long value);
+    /// With digits significant digits, null for NaN and infinities, which JSON has no notation for
+    void number(double value, uint8_t digits);
+    void boolean(bool value) { value ? raw("true", 4) : raw("false", 5); }
+    void null() { raw("null", 4); }
+
+    const char *data() const { return _buffer; }
+    size_t length() const { return _length; }
+    bool overflow() const { return _overflow; }
+
+private:
+    char *_buffer;
+    size_t _capacity;
+    size_t _length = 0;
+    bool _overflow = false;
+};
+
+/// JSON that is already serialized, e.g. by ArduinoJson, passed through as it is
+struct socketIORawJson_t {
+    const char *json;
+    size_t length;
+
+    explicit socketIORawJson_t(const char *str) : json(str), length(str ? strlen(str) : 0) {}
+    socketIORawJson_t(const char *str, size_t len) : json(str), length(len) {}
+};
+
+/**
+ * How values are written as JSON. Specialize it to emit your own types:
+ *
+ * template <> struct socketIOJson<Point> {
+ *     static void write(socketIOJsonWriter_t &out, const Point &p) {
+ *         out.raw("{\"x\":"); out.number(p.x, 7); out.raw(",\"y\":"); out.number(p.y, 7); out.raw("}");
+ *     }
+ * };
+ */
+template <typename T, typename Enable = void>
+struct socketIOJson;
+
+template <>
+struct socketIOJson<bool> {
+    static void write(socketIOJsonWriter_t &out, bool value) { out.boolean(value); }
+};
+
+/// Integers, with the arithmetic of the widest type they need
+template <typename T>
+struct socketIOJson<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+    typedef typename std::conditional<(sizeof(T) > sizeof(long)),
+        typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type,
+        typename std::conditional<std::is_signed<T>::value, long, unsigned long>::type>::type wide_t;
+    static void write(socketIOJsonWriter_t &out, T value) { out.number((wide_t)value); }
+};
+
+template <>
+struct socketIOJson<float> {
+    static void write(socketIOJsonWriter_t &out, float value) { out.number(value, 7); }
+};
+
+template <>
+struct socketIOJson<double> {
+    static void write(socketIOJsonWriter_t &out, double value) { out.number(value, 15); }
+};
+
+/// C strings, NULL is written as null. String literals decay to them at the call
+template <>
+struct socketIOJson<const char *> {
+    static void write(socketIOJsonWriter_t &out, const char *value) {
+        if (value) {
+            out.string(value);
+        } else {
+            out.null();
+        }
+    }
+};
+
+template <>
+struct socketIOJson<char *> : socketIOJson<const char *> {};
+
+template <>
+struct socketIOJson<std::nullptr_t> {
+    static void write(socketIOJsonWriter_t &out, std::nullptr_t) { out.null(); }
+};
+
+template <>
+struct socketIOJson<String> {
+    static void write(socketIOJsonWriter_t &out, const String &value) { out.string(value.c_str(), value.length()); }
+};
+
+template <>
+struct socketIOJson<socketIORawJson_t> {
+    static void write(socketIOJsonWriter_t &out, const socketIORawJson_t &value) { out.raw(value.json, value.length); }
+};
+
+/// Writes the arguments as the elements of a JSON array, each preceded by a comma
+inline void socketIOJsonArgs(socketIOJsonWriter_t &) {}
+
+template <typename T, typename... Args>
+void socketIOJsonArgs(socketIOJsonWriter_t &out, const T &value, const Args &... args) {
+    out.raw(",", 1);
+    socketIOJson<typename std::decay<T>::type>::write(out, value);
+    socketIOJsonArgs(out, args...);
+}
+
+typedef enum : uint8_t {
+    sIOjson_MISSING, ///< No such member or element, or malformed JSON
+    sIOjson_NULL,
+    sIOjson_BOOL,
+    sIOjson_NUMBER,
+    sIOjson_STRING,
+    sIOjson_ARRAY,
+    sIOjson_OBJECT,
+} socketIOJsonType_t;
+
+/**
+ * Reads JSON where it lies, e.g. in the receive buffer, without allocating
+ * or parsing more than it is asked for: a cursor is a view of one value,
+ * members and elements are found by skipping over the values before them
+ * and decoded only when read. get("sensor.temp") follows a path of member
+ * names and array indices, first() and next() iterate. A cursor on what is
+ * missing or malformed reads as MISSING and gives the fallback values.
+ * Cursors are only valid as long as the JSON they point into.
+ */
+class socketIOJsonCursor_t {
+public:
+    socketIOJsonCursor_t() {}
+    /// The value at the start of json, the ones after it follow with next(), if separated by commas
+    socketIOJsonCursor_t(const char *json, size_t length);
+    explicit socketIOJsonCursor_t(const char *json) : socketIOJsonCursor_t(json, json ? strlen(json) : 0) {}
+
+    socketIOJsonType_t type() const;
+    bool exists() const { return _ptr != NULL; }
+    bool isNull() const { return type() == sIOjson_NULL; }
+
+    /// The member of an object, keys are compared as they are written
+    socketIOJsonCursor_t operator[](const char *key) const;
+    /// The element of an array
+    socketIOJsonCursor_t operator[](size_t index) const;
+    socketIOJsonCursor_t operator[](int index) const { return (*this)[(size_t)index]; }
+    /// Follows a path of keys and indices separated by dots, "sensor.temp" or "readings.2.value"
+    socketIOJsonCursor_t get(const char *path) const;
+    /// The first element of an array or member of an object, the other ones follow with next()
+    socketIOJsonCursor_t first() const;
+    socketIOJsonCursor_t next() const;
+    /// The key of a member found by first(), next() or a lookup, a string
+    socketIOJsonCursor_t key() const;
+    /// Elements or members, counted by skipping over them
+    size_t size() const;
+
+    long asLong(long fallback = 0) const;
+    unsigned long asULong(unsigned long fallback = 0) const;
+    double asDouble(double fallback = 0) const;
+    float asFloat(float fallback = 0) const { return (float)asDouble(fallback); }
+    bool asBool(bool fallback = false) const;
+    /**
+     * Copies a string value, unescaped and null terminated, cut short to fit.
+     * @return the length of the whole string, as snprintf(), 0 if it is not a string
+     */
+    size_t asString(char *buffer, size_t size) const;
+    /// Whether it is a string of that value, escapes decoded
+    bool equals(const char *str) const;
+
+    /// The JSON of the value as it was received
+    const char *raw() const { return _ptr; }
+    size_t length() const { return _length; }
+
+private:
+    socketIOJsonCursor_t(const char *value, const char *end, const char *key);
+    socketIOJsonCursor_t member(const char *p, const char *end) const;
+
+    const char *_ptr = NULL;
+    size_t _length = 0;
+    // where the container, or the list given to the constructor, ends
+    const char *_end = NULL;
+    // the opening quote of the key of a member
+    const char *_key = NULL;
+};
+
+/**
+ * An event name and its packet prefix, 42["name", built by the compiler from
+ * a string literal that needs no escaping: SOCKETIO_EVENT("temperature").
+ */
+struct socketIOEvent_t {
+    const char *name;
+    const char *prefix;
+    size_t prefixLength;
+};
+#define SOCKETIO_EVENT(name) (socketIOEvent_t{ name, "42[\"" name "\"", sizeof("42[\"" name "\"") - 1 })
+
+#endif
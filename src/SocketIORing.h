@@ -0,0 +1,108 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _SOCKET_IO_RING_H
+#define _SOCKET_IO_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+
+/**
+ * Lock-free ring of records for one producer and one consumer, each on its
+ * own task: push() is only called by the one, pop(), peek() and drop() by
+ * the other. Records are up to 65535 bytes, stored behind their 2 byte
+ * length, and may wrap around the end of the N bytes, a power of two.
+ */
+template <size_t N>
+class SocketIORing {
+    static_assert(N >= 16 && (N & (N - 1)) == 0, "the ring length has to be a power of two");
+public:
+    /// Appends a record made of two pieces, false if it does not fit
+    bool push(const void *data, size_t length, const void *more = NULL, size_t moreLength = 0) {
+        size_t total = length + moreLength;
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (total > 0xFFFF || N - (tail - _head.load(std::memory_order_acquire)) < 2 + total) return false;
+        const uint8_t header[2] = { (uint8_t)(total >> 8), (uint8_t)total };
+        copyIn(tail, header, 2);
+        copyIn(tail + 2, data, length);
+        copyIn(tail + 2 + length, more, moreLength);
+        _tail.store(tail + 2 + total, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Moves the oldest record to out, cut to capacity bytes if longer.
+     * @param length set to the length of the record
+     * @return false if the ring is empty
+     */
+    bool pop(void *out, size_t capacity, size_t &length) {
+        if (!peek(out, capacity, length)) return false;
+        drop();
+        return true;
+    }
+
+    /// As pop(), the record stays in the ring until drop()
+    bool peek(void *out, size_t capacity, size_t &length) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) return false;
+        uint8_t header[2];
+        copyOut(head, header, 2);
+        length = header[0] << 8 | header[1];
+        copyOut(head + 2, out, length < capacity ? length : capacity);
+        return true;
+    }
+
+    /// Removes the oldest record, which has to be there
+    void drop() {
+        size_t head = _head.load(std::memory_order_relaxed);
+        uint8_t header[2];
+        copyOut(head, header, 2);
+        _head.store(head + 2 + (header[0] << 8 | header[1]), std::memory_order_release);
+    }
+
+    bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+
+private:
+    void copyIn(size_t position, const void *data, size_t length) {
+        if (length == 0) return;
+        size_t offset = position & (N - 1);
+        size_t n = length < N - offset ? length : N - offset;
+        memcpy(&_buffer[offset], data, n);
+        memcpy(_buffer, (const uint8_t *)data + n, length - n);
+    }
+    void copyOut(size_t position, void *out, size_t length) const {
+        if (length == 0) return;
+        size_t offset = position & (N - 1);
+        size_t n = length < N - offset ? length : N - offset;
+        memcpy(out, &_buffer[offset], n);
+        memcpy((uint8_t *)out + n, _buffer, length - n);
+    }
+
+    uint8_t _buffer[N];
+    // positions count up forever, the producer owns _tail and the consumer _head
+    std::atomic<size_t> _head{0};
+    std::atomic<size_t> _tail{0};
+};
+
+#endif
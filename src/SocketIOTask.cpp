@@ -0,0 +1,215 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <SocketIOTask.h>
+#include <algorithm>
+
+#if defined(ESP32) || defined(SOCKETIO_HOST)
+
+bool SocketIOTaskBase::start(const char *host, unsigned int port, const char *root_ca) {
+    return start(host, port, root_ca ? sIOtransport_TLS : sIOtransport_PLAIN, root_ca);
+}
+
+bool SocketIOTaskBase::start(const char *host, unsigned int port, socketIOTransport_t transport, const char *root_ca) {
+    if (_running.load()) return false;
+    _host = host;
+    _port = port;
+    _transport = transport;
+    _root_ca = root_ca;
+    _client._eventSink = [this](const socketIOPacketView_t &packet) { receive(packet); };
+    _running.store(true);
+#if defined(ESP32)
+    _done.store(false);
+    if (xTaskCreatePinnedToCore(taskMain, "socketio", SOCKETIO_TASK_STACK, this, SOCKETIO_TASK_PRIORITY, &_handle, SOCKETIO_TASK_CORE) != pdPASS) {
+        DEBUG_WEBSOCKETS("Cannot create the I/O task");
+        _done.store(true);
+        _running.store(false);
+        _client._eventSink = nullptr;
+        return false;
+    }
+#else
+    _thread = std::thread(&SocketIOTaskBase::run, this);
+#endif
+    return true;
+}
+
+void SocketIOTaskBase::stop() {
+    if (!_running.exchange(false)) return;
+    wake();
+#if defined(ESP32)
+    while (!_done.load()) {
+        delay(1);
+    }
+    _handle = NULL;
+#else
+    _thread.join();
+#endif
+    _client._eventSink = nullptr;
+    _state.store(_client.state());
+}
+
+#if defined(ESP32)
+void SocketIOTaskBase::taskMain(void *task) {
+    SocketIOTaskBase *self = (SocketIOTaskBase *)task;
+    self->run();
+    self->_done.store(true);
+    vTaskDelete(NULL);
+}
+#endif
+
+void SocketIOTaskBase::run() {
+    _client.connect(_host, _port, _transport, _root_ca);
+    while (_running.load(std::memory_order_acquire)) {
+        _received = false;
+        _client.loop();
+        // the packets the application emitted, as far as the transmit buffer takes them
+        bool sent = false;
+        size_t length;
+        while (_client.writable() && _outbound.peek(_ioScratch, _ioScratchLength - 1, length)) {
+            bool connected = _client.connected();
+            if (!_client.sendSerialized(_ioScratch, length, true)) {
+                // kept until there is a connection, or room once the queued frames are out
+                if (!connected || _client.queuedBytes() > 0) break;
+                DEBUG_WEBSOCKETS("Packet refused by the client, dropped");
+                _droppedEmits.fetch_add(1, std::memory_order_relaxed);
+            }
+            _outbound.drop();
+            sent = true;
+        }
+        _state.store(_client.state(), std::memory_order_release);
+        // the ping interval and the rings leave plenty of slack for a tick of sleep
+        if (sent || _received) {
+            yield();
+        } else {
+            idle();
+        }
+    }
+    _client.disconnect();
+}
+
+#if defined(ESP32)
+void SocketIOTaskBase::idle() {
+    ulTaskNotifyTake(pdTRUE, 1);
+}
+
+void SocketIOTaskBase::wake() {
+    if (_handle) xTaskNotifyGive(_handle);
+}
+#else
+void SocketIOTaskBase::idle() {
+    std::unique_lock<std::mutex> lock(_wakeMutex);
+    _wakeCondition.wait_for(lock, std::chrono::milliseconds(1), [this]() { return _wake; });
+    _wake = false;
+}
+
+void SocketIOTaskBase::wake() {
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _wake = true;
+    }
+    _wakeCondition.notify_one();
+}
+#endif
+
+/// On the I/O task, from the client's dispatch of a received event
+void SocketIOTaskBase::receive(const socketIOPacketView_t &packet) {
+    _received = true;
+    char event[64];
+    size_t eventLength = std::min(packet.event.length, sizeof(event) - 1);
+    memcpy(event, packet.event.ptr, eventLength);
+    event[eventLength++] = 0;
+    if (!_inbound.push(event, eventLength, packet.data.ptr, packet.data.length)) {
+        DEBUG_WEBSOCKETS("Ring to the application full, event dropped");
+        _droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool SocketIOTaskBase::on(const char *event, viewCallback_fn func) {
+    uint32_t hash = socketIOHash(event);
+    for (size_t i = 0; i < _handlerCount; i++) {
+        if (_handlers[i].hash == hash && strcmp(_handlers[i].event, event) == 0) {
+            _handlers[i].callback = func;
+            return true;
+        }
+    }
+    if (_handlerCount == SOCKETIO_MAX_HANDLERS) return false;
+    _handlers[_handlerCount].hash = hash;
+    _handlers[_handlerCount].event = event;
+    _handlers[_handlerCount].callback = func;
+    _handlerCount++;
+    return true;
+}
+
+size_t SocketIOTaskBase::poll(size_t max) {
+    size_t count = 0;
+    size_t length;
+    while ((max == 0 || count < max) && _inbound.pop(_scratch, _scratchLength, length)) {
+        count++;
+        length = std::min(length, _scratchLength);
+        socketIOPacketView_t packet;
+        packet.event = socketIOView_t(_scratch, strnlen(_scratch, length));
+        if (packet.event.length == length) continue;
+        packet.data = socketIOView_t(&_scratch[packet.event.length + 1], length - packet.event.length - 1);
+        uint32_t hash = socketIOHash(packet.event);
+        for (size_t i = 0; i < _handlerCount; i++) {
+            if (_handlers[i].hash == hash && packet.event.equals(_handlers[i].event)) {
+                // no ack id, answers are not sent
+                _handlers[i].callback(packet.data, socketIOAck_t(&_client, &packet));
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+bool SocketIOTaskBase::emit(const char *event, const char *content) {
+    socketIOJsonWriter_t out = writer();
+    out.raw("42[", 3);
+    out.string(event);
+    if (content) {
+        // quoted unless it is an object or an array, as SocketIOClient::emit()
+        bool quote = content[0] != '{' && content[0] != '[';
+        out.raw(quote ? ",\"" : ",", quote ? 2 : 1);
+        out.raw(content);
+        if (quote) out.raw("\"", 1);
+    }
+    out.raw("]", 1);
+    return push(out);
+}
+
+socketIOJsonWriter_t SocketIOTaskBase::writer() {
+    // the task sends the packet from _ioScratch, behind a frame header in the transmit buffer
+    return socketIOJsonWriter_t(_scratch, std::min(_scratchLength, _ioScratchLength - WS_MAX_HEADER_LEN - 1));
+}
+
+bool SocketIOTaskBase::push(const socketIOJsonWriter_t &out) {
+    if (out.overflow()) {
+        DEBUG_WEBSOCKETS("Event longer than the transmit buffer dropped");
+        return false;
+    }
+    if (!_outbound.push(out.data(), out.length())) return false;
+    wake();
+    return true;
+}
+
+#endif
@@ -0,0 +1,197 @@
+/*
+socket.io-arduino-client: a Socket.IO client for the Arduino
+Based on the Kevin Rohling WebSocketClient & Bill Roy Socket.io Lbrary
+Copyright 2015 Florent Vidal
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _SOCKET_IO_TASK_H
+#define _SOCKET_IO_TASK_H
+
+#include <SocketIOClient.h>
+#include <SocketIORing.h>
+
+#if defined(ESP32) || defined(SOCKETIO_HOST)
+#include <atomic>
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+// Bytes of each of the two rings between the I/O task and the application, a power of two
+#ifndef SOCKETIO_TASK_RING_LEN
+#define SOCKETIO_TASK_RING_LEN 2048
+#endif
+// The FreeRTOS task the socket is served from, on the core the WiFi stack runs on by default
+#ifndef SOCKETIO_TASK_STACK
+#define SOCKETIO_TASK_STACK 8192
+#endif
+#ifndef SOCKETIO_TASK_PRIORITY
+#define SOCKETIO_TASK_PRIORITY 2
+#endif
+#ifndef SOCKETIO_TASK_CORE
+#define SOCKETIO_TASK_CORE 0
+#endif
+
+/**
+ * Serves a SocketIOClient from a task of its own, a FreeRTOS task pinned to
+ * SOCKETIO_TASK_CORE on ESP32 and a std::thread on host builds, so slow
+ * handlers do not hold up pongs and reading the socket. The task owns the
+ * client from start() to stop(): the connection, framing, heartbeat and
+ * reconnects. Events of the default namespace come to the application
+ * through a lock-free ring and are handed to the handlers given to on()
+ * when poll() is called, emit() serializes packets into the other ring for
+ * the task to send. Both rings hold SOCKETIO_TASK_RING_LEN bytes.
+ *
+ * Set the client up before start() and leave it alone until stop(). Events
+ * cannot be acked this way and binary attachments are not passed on.
+ * Packets emitted stay in the ring until the client takes them, so while it
+ * is disconnected the ring fills up and emit() returns false.
+ *
+ * The scratch buffers events pass through are those of SocketIOTaskT, sized
+ * as the client's.
+ */
+class SocketIOTaskBase {
+public:
+	SocketIOTaskBase(const SocketIOTaskBase &) = delete;
+	SocketIOTaskBase &operator=(const SocketIOTaskBase &) = delete;
+	~SocketIOTaskBase() { stop(); }
+
+	/// Starts the task, which connects the client to host
+	bool start(const char *host, unsigned int port, const char *root_ca = NULL);
+	bool start(const char *host, unsigned int port, socketIOTransport_t transport, const char *root_ca = NULL);
+	/// Disconnects and ends the task, the client is the caller's again
+	void stop();
+
+	/// Registers the handler of an event, called by poll() from then on
+	bool on(const char *event, viewCallback_fn);
+	/**
+	 * Calls the handlers of the events received since, at most max of them (0: all).
+	 * @return the number of events taken from the ring
+	 */
+	size_t poll(size_t max = 0);
+
+	/// As SocketIOClient::emit(), without an ack. False if the ring to the task is full
+	bool emit(const char *event, const char *content);
+	/// As SocketIOClient::emitArgs(), without an ack
+	template <typename... Args>
+	bool emitArgs(const char *event, const Args &... args) {
+		socketIOJsonWriter_t out = writer();
+		out.raw("42[", 3);
+		out.string(event);
+		socketIOJsonArgs(out, args...);
+		out.raw("]", 1);
+		return push(out);
+	}
+	template <typename... Args>
+	bool emitArgs(const socketIOEvent_t &event, const Args &... args) {
+		socketIOJsonWriter_t out = writer();
+		out.raw(event.prefix, event.prefixLength);
+		socketIOJsonArgs(out, args...);
+		out.raw("]", 1);
+		return push(out);
+	}
+
+	/// The client's state as the task last saw it
+	socketIOState_t state() const { return (socketIOState_t)_state.load(std::memory_order_acquire); }
+	bool connected() const { return state() == sIOstate_CONNECTED; }
+	/// Events dropped because the ring to the application was full
+	unsigned long droppedEvents() const { return _droppedEvents.load(std::memory_order_relaxed); }
+	/// Packets emitted that the connected client refused, e.g. longer than the server's maxPayload
+	unsigned long droppedEmits() const { return _droppedEmits.load(std::memory_order_relaxed); }
+
+protected:
+	SocketIOTaskBase(SocketIOClientBase &client, char *scratch, size_t scratchLength, char *ioScratch, size_t ioScratchLength) :
+		_client(client), _scratch(scratch), _scratchLength(scratchLength), _ioScratch(ioScratch), _ioScratchLength(ioScratchLength) {}
+
+private:
+	SocketIOClientBase &_client;
+	const char *_host = NULL;
+	unsigned int _port = 0;
+	socketIOTransport_t _transport = sIOtransport_PLAIN;
+	const char *_root_ca = NULL;
+	std::atomic<bool> _running{false};
+	std::atomic<uint8_t> _state{sIOstate_DISCONNECTED};
+	std::atomic<unsigned long> _droppedEvents{0};
+	std::atomic<unsigned long> _droppedEmits{0};
+#if defined(ESP32)
+	std::atomic<bool> _done{true};
+	TaskHandle_t _handle = NULL;
+	static void taskMain(void *task);
+#else
+	std::thread _thread;
+	std::mutex _wakeMutex;
+	std::condition_variable _wakeCondition;
+	bool _wake = false;
+#endif
+	void run();
+	// The task sleeps for a tick when idle, emit() wakes it up early
+	void idle();
+	void wake();
+	bool _received = false;
+	void receive(const socketIOPacketView_t &packet);
+	socketIOJsonWriter_t writer();
+	bool push(const socketIOJsonWriter_t &out);
+
+	// Records of the inbound ring: the event, its terminator and its data.
+	// Those of the outbound ring: a whole packet, 42["event",...]
+	SocketIORing<SOCKETIO_TASK_RING_LEN> _inbound;
+	SocketIORing<SOCKETIO_TASK_RING_LEN> _outbound;
+	// _scratch is the application's, for emit() and poll(), _ioScratch the task's
+	char *_scratch;
+	size_t _scratchLength;
+	char *_ioScratch;
+	size_t _ioScratchLength;
+
+	struct handler_t {
+		uint32_t hash = 0;
+		const char *event = NULL;
+		viewCallback_fn callback;
+	};
+	handler_t _handlers[SOCKETIO_MAX_HANDLERS];
+	size_t _handlerCount = 0;
+};
+
+/**
+ * The task of a SocketIOClientT<RxBytes, TxBytes, ...>: events received go
+ * through a scratch buffer as long as its receive buffer, packets emitted
+ * through one as long as its transmit buffer.
+ */
+template <size_t RxBytes, size_t TxBytes>
+class SocketIOTaskT : public SocketIOTaskBase {
+public:
+	template <size_t MaxHandlers, size_t MaxPendingAcks>
+	explicit SocketIOTaskT(SocketIOClientT<RxBytes, TxBytes, MaxHandlers, MaxPendingAcks> &client) :
+		SocketIOTaskBase(client, _scratchBuffer, RxBytes, _ioScratchBuffer, TxBytes) {}
+	// the task is stopped before the buffers it uses go
+	~SocketIOTaskT() { stop(); }
+
+private:
+	char _scratchBuffer[RxBytes];
+	char _ioScratchBuffer[TxBytes];
+};
+
+typedef SocketIOTaskT<DATA_BUFFER_LEN, TX_BUFFER_LEN> SocketIOTask;
+
+#endif
+#endif